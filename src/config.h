@@ -101,13 +101,46 @@
 #define M2_DAQ_VIRTUAL_NUM_ADC 16
 #define M2_DAQ_VIRTUAL_MIN -1e18
 #define M2_DAQ_VIRTUAL_MAX  1e18
+#define M2_DAQ_VIRTUAL_RANGE 10.0          // V, simulated boards only (node "virtual:...")
+#define M2_DAQ_VIRTUAL_RATE_KHZ 250.0      // aggregate kS/s
+#define M2_DAQ_VIRTUAL_NOISE 1e-3          // V rms
+#define M2_DAQ_VIRTUAL_LATENCY 2e-3        // s
+#define M2_DAQ_VIRTUAL_CONVERT_TIME 4e-6   // s
+#define M2_DAQ_VIRTUAL_MAXDATA 0xFFFF      // 16-bit converter
 #define M2_DAQ_COMEDI_BUFFER_SIZE (64*1024)
+#define M2_DAQ_MAX_AVG 64                  // scans averaged per point-mode reading, background mode only
+#define M2_DAQ_BACKGROUND_RATE_KHZ 10.0    // scan rate for background point-mode sampling
+#define M2_DAQ_BACKGROUND_TIMEOUT 0.5      // s, wait for the first scan after (re)starting
 #define M2_DAQ_EXTRA_SCAN_TIME 800e-3
+#define M2_DAQ_SCAN_WATERMARK 0.5          // fraction of the device buffer to let fill before each scan read
+#define M2_DAQ_POOL_HUGEPAGES 0            // back scan buffers with hugepages (MAP_HUGETLB, else transparent)
+#define M2_DAQ_POOL_PREFAULT 1             // touch scan buffer pages when (re)allocated rather than while scanning
 #define M2_GPIB_MAX_BRD 6
 #define M2_GPIB_MAX_PAD 32
 #define M2_GPIB_BUF_LENGTH 255
+#define M2_GPIB_COST_WEIGHT 0.2            // weight of the latest query when averaging per-slot cost
+#define M2_GPIB_MAX_COALESCE 6             // slots merged into one compound query (SR830 SNAP? takes up to 6)
+#define M2_GPIB_SIM_OVERHEAD 1e-3          // s per transfer on a simulated bus (node "sim:...")
+#define M2_GPIB_LOAD_RESET 0.9             // bus load below which an overload warning is re-armed
+#define M2_GPIB_MAX_REQUEST 16             // queued terminal requests, all boards
+#define M2_GPIB_REQUEST_TIMEOUT 10.0       // s, default time a terminal request may wait for the bus
+#define M2_GPIB_WRITE_INTERVAL 0.1         // s, default minimum time between setpoint writes to one slot
+#define M2_GPIB_STATS_WINDOW 1.0           // s, period over which bus utilization and achieved rates are measured
+#define M2_GPIB_TIMEOUT 1.0                // s, device timeout for new, failing, and terminal queries (rounded up to an ibtmo() step)
+#define M2_GPIB_TIMEOUT_FACTOR 5.0         // polling timeout as a multiple of the device's typical reply latency
+#define M2_GPIB_TIMEOUT_MIN 0.1            // s, lower limit of the polling timeout
+#define M2_GPIB_BACKOFF_MIN 0.5            // s, polling pause after a failed query, doubled for each further failure
+#define M2_GPIB_BACKOFF_MAX 30.0           // s
+#define M2_GPIB_DOWN_FAILS 3               // consecutive failures before a device is reported as not responding
+
+// buffers:
+#define M2_BUFFER_RAM_BUDGET_MB 4096.0     // default heap for buffer data, beyond which new points spill to scratch files (negative: never)
+#define M2_BUFFER_SCRATCH_DIR ""           // default directory for scratch files ("" means $TMPDIR, else /tmp)
 
 // libs:
+#define M2_MEM_POOL_HISTORY 8
+#define M2_MEM_HUGEPAGE_SIZE (2*1024*1024)
+#define M2_MEM_FILE_EXTENT (64*1024*1024)  // bytes of scratch file mapped at a time
 #define M2_MCF_LINE_LENGTH 1024
 #define M2_BLOB_MAX_PTR 3
 #define M2_BLOB_MAX_NUM 2
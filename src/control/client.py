@@ -44,13 +44,28 @@ def hello (msg) :
 
 def xleep (t) : return _mezurit2control.xleep(t)
 
-def gpib (brd, pad, msg, eos=0, expect_reply=True) :
-	reply = send_recv('gpib_send_recv;id|{0:d};pad|{1:d};eos|{2:d};msg|{3:s};expect_reply|{4:d}'.format(brd, pad, eos, msg, expect_reply))
+def gpib (brd, pad, msg, eos=0, expect_reply=True, priority=0, timeout=10.0) :
+	reply = send_recv('gpib_send_recv;id|{0:d};pad|{1:d};eos|{2:d};msg|{3:s};expect_reply|{4:d};priority|{5:d};timeout|{6:f}'.format(brd, pad, eos, msg, expect_reply, priority, timeout))
 	if expect_reply : return arg(reply, 0) if cmd(reply) == 'gpib_send_recv' else 'Error'
-	else : printnow('Message sent.\n')
+	elif cmd(reply) == 'gpib_send_recv' : printnow('Message queued.\n')
+	else : printnow('Error! GPIB request not accepted ({0:s}).\n'.format(cmd(reply)))
+
+def gpib_stats (brd, slot=-1) :  # whole board by default
+	reply = send_recv('gpib_stats;id|{0:d};slot|{1:d}'.format(brd, slot))
+	if cmd(reply) != 'gpib_stats' : return {}
+	return dict((s.split('|')[0], float(s.split('|')[1])) for s in reply.split(';')[1:])
+
+def gpib_forget (brd, pad=-1) :  # whole board by default
+	return send_recv('gpib_forget;id|{0:d};pad|{1:d}'.format(brd, pad)) == 'gpib_forget'
 
 # Examples: gpib(0, 8, 'OFF', expect_reply=False) >> 'Sent'
 #           gpib(0, 8, '*IDN?')                   >> 'TOASTMASTER 5000'
+#           gpib(0, 8, '*IDN?', priority=1)       >> served before other queued requests
+#           (a request still queued after 'timeout' seconds is answered with 'Error')
+#           gpib_stats(0)['utilization']          >> 0.42
+#           gpib_stats(0, 1)['rate']              >> 1.9 (polls per second achieved by slot 1)
+#           gpib_stats(0, 1)['refs']              >> 0.0 (no expression reads slot 1 anymore, so it is not polled)
+#           gpib_forget(0, 8)                     >> True (swapped the instrument, so ask it to identify itself again)
 
 ##################  Test the connection  ###################
 
@@ -129,6 +144,13 @@ def fire_scope        ()                : return send_recv_check('set_scanning;o
 def fire_scope_pulse  (channel, target) : return fire_scope() if request_pulse(channel, target) else False
 def cancel_scope      ()                : return send_recv_check('set_scanning;on|0')
 
+def scan_stats (_id) :
+	reply = send_recv('scan_stats;id|{0:d}'.format(_id))
+	if cmd(reply) != 'scan_stats' : return {}
+	return dict((s.split('|')[0], float(s.split('|')[1])) for s in reply.split(';')[1:])
+
+# Example: scan_stats(0)['peak_fill'] >> 0.503
+
 #######################  Triggering  ########################
 
 def arm_trigger    (_id)    : return send_recv_check('arm_trigger;id|{0:d}'.format(_id))
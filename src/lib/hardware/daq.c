@@ -18,22 +18,23 @@
 #include "daq.h"
 
 #include <stdlib.h>  // malloc()
+#include <stdio.h>   // sscanf()
+#include <stdint.h>
+#include <string.h>  // strncmp()
 #include <unistd.h>
 #include <math.h>
 
 #include <lib/status.h>
 #include <lib/util/str.h>
 #include <lib/util/num.h>
+#include <lib/util/mem.h>
 #include <lib/hardware/timing.h>
 
 #if COMEDI
 #include <comedilib.h>
 #elif NIDAQ
 #include <nidaq.h>
-#include <stdio.h>  // sscanf()
 #elif NIDAQMX
-#include <stdio.h>  // sprintf()
-#include <stdint.h>
 #define _NI_int64_DEFINED_
 #define _NI_uInt64_DEFINED_
 typedef int64_t int64;
@@ -60,7 +61,9 @@ enum
 
 struct AnalogChannel
 {
-	bool req;
+	bool req;                  // AI: part of the multi setup
+	const void **owner;        // AI: expressions reading the channel, see daq_AI_hold()
+	int N_owner, owner_size;
 	int known;
 	double voltage, min, max;
 #if COMEDI
@@ -85,12 +88,30 @@ struct SubDevice
 
 };
 
+struct VirtualDevice  // simulated comedi-like board, selected with a node string such as "virtual:rate=250,noise=1e-3"
+{
+	// options:
+	double rate_kHz;      // max aggregate conversion rate
+	double noise;         // V rms, gaussian
+	double latency;       // s, delay before converted samples become readable
+	double convert_time;  // s per point-mode conversion, not counting settling
+	int N_ao, N_ai;
+	ssize_t buffer_size;  // bytes
+	uint32_t seed;
+
+	// state:
+	uint32_t rng;
+	bool overrun;
+	int scan_chan[M2_DAQ_MAX_CHAN];
+
+};
+
 struct DaqBoard
 {
 	char *node;
-	bool is_real, is_connected, scan_prepared;
+	bool is_real, is_virtual, is_connected, scan_prepared, scan_armed;
 
-	char *info_driver, *info_full_node, *info_board, *info_board_abrv, *info_output, *info_input, *info_settle;
+	char *info_driver, *info_full_node, *info_board, *info_board_abrv, *info_output, *info_input, *info_settle, *info_point;
 
 	// device setup
 #if COMEDI
@@ -98,6 +119,7 @@ struct DaqBoard
 #elif NIDAQ
 	i16 nidaq_num, nidaq_bcode;
 #endif
+	struct VirtualDevice vdev;
 	struct SubDevice ao, ai;
 
 	// multi setup (AI only, slightly complicated to avoid ghosting on multiplexed ADCs)
@@ -111,21 +133,59 @@ struct DaqBoard
 #elif NIDAQ
 	f64 multi_voltage[M2_DAQ_MAX_CHAN * (M2_DAQ_MAX_SETTLE + 1)];  // pre-read(s) + final read == total samples per channel
 #elif NIDAQMX
-	float64 multi_voltage[M2_DAQ_MAX_CHAN];
+	float64 multi_voltage[M2_DAQ_MAX_CHAN * M2_DAQ_MAX_AVG];  // room for background reads
 	TaskHandle multi_task;
 #endif
 
+	// batched AO writes (see daq_AO_batch_begin())
+	bool ao_pending[M2_DAQ_MAX_CHAN];
+	int ao_N_pending;
+#if COMEDI
+	lsampl_t ao_raw[M2_DAQ_MAX_CHAN];
+	comedi_insn ao_insn[M2_DAQ_MAX_CHAN];
+	comedi_insnlist ao_insnlist;
+#endif
+
+	// background setup (point mode served by a continuous, hardware-clocked acquisition)
+	int bg_avg;                                       // scans averaged per reading, 0 = off
+	bool bg_running;
+	double bg_ring[M2_DAQ_MAX_AVG][M2_DAQ_MAX_CHAN];  // index: [scan][pci]
+	int bg_index, bg_filled;
+	double bg_t_last;                                 // virtual only: global_timer time of the last scan generated
+#if COMEDI
+	comedi_cmd bg_cmd;
+	unsigned int bg_chanlist[M2_DAQ_MAX_CHAN];
+	void *bg_raw;                                     // a device buffer's worth plus one partial scan
+	ssize_t bg_partial;                               // bytes of an incomplete scan carried over to the next read
+#endif
+
 	// scan setup (AI only)
 	int scan_N_chan, scan_pci[M2_DAQ_MAX_CHAN];
 	double scan_total_time;
 	ssize_t scan_total, scan_offset;  // scan_total = N_pt * N_chan
 	long scan_saved;                  // scan_saved refers to complete points (all samples present)
-	void *scan_buffer;
+	void *scan_buffer;                // points into scan_pool, which is kept between scans
+	MemPool scan_pool;
 	Timer *scan_timer;
+	double scan_t0, scan_t0_err;      // release time on global_timer, with half the width of the trigger call
+	double scan_t_offset;             // scan_t0 relative to the earliest board (see daq_SCAN_align())
 	int scan_dummy_map[M2_DAQ_MAX_CHAN][2];
+
+	// scan read scheduling
+	ssize_t scan_buffer_size;         // bytes, or 0 if the device buffer level is unknown (read every scan_read_interval)
+	double scan_byte_rate;            // bytes/s into the device buffer
+	double scan_read_interval, scan_next_poll;  // on scan_timer
+
+	// scan telemetry (see daq_SCAN_stats())
+	ssize_t scan_b_sampl;             // bytes per sample in the device buffer
+	ssize_t scan_peak_fill;           // bytes
+	long scan_N_read, scan_N_poll, scan_N_retry, scan_N_overrun;
+	double scan_read_bytes, scan_read_time, scan_read_time_max;
+	double scan_duration;             // trigger to stop
 #if COMEDI
 	comedi_cmd scan_cmd;
 	unsigned int scan_chanlist[M2_DAQ_MAX_CHAN];
+	bool scan_int_trig;               // start_src = TRIG_INT, so daq_SCAN_arm() can load the command ahead of time
 #elif NIDAQ
 	i16 scan_phys_chan[M2_DAQ_MAX_CHAN], scan_phys_gain[M2_DAQ_MAX_CHAN];
 	i16 scan_tbcode;
@@ -138,9 +198,19 @@ struct DaqBoard
 
 static struct DaqBoard daq_board[M2_DAQ_MAX_BRD];
 static Timer *global_timer;
+static bool ao_batching;
 
 static void daq_board_close   (struct DaqBoard *board);
 static void subdevice_connect (struct DaqBoard *board, struct SubDevice *subdev, int type);
+static bool ao_write_now      (struct DaqBoard *board, int chan, double voltage);
+static bool ao_commit         (struct DaqBoard *board);
+static void multi_setup       (struct DaqBoard *board);
+static void multi_rebuild     (struct DaqBoard *board);
+static void background_start  (struct DaqBoard *board);
+static void background_stop   (struct DaqBoard *board);
+static bool background_read   (struct DaqBoard *board);
+static bool background_tick   (struct DaqBoard *board);
+static ssize_t scan_fill      (struct DaqBoard *board);
 #if NIDAQ
 static char * bcode_to_str (int bcode);
 #elif NIDAQMX
@@ -148,7 +218,13 @@ static char * get_mx_product_type (const char *node);
 static bool create_mx_scan (TaskHandle *task, char *node, float64 rate, uInt64 spc, int N_chan, int *phys_chan);
 static int32 mention_mx_error (int32 code);
 #endif
+static bool         virtual_parse     (struct VirtualDevice *vdev, const char *node);
+static double       virtual_gauss     (struct VirtualDevice *vdev);
+static unsigned int virtual_digitize  (struct DaqBoard *board, int chan, double t);
+static double       virtual_to_phys   (unsigned int raw);
+static long         virtual_converted (struct DaqBoard *board);
 
+#include "daq_virtual.c"
 #include "daq_point_io.c"
 #include "daq_scan.c"
 
@@ -160,8 +236,10 @@ void daq_init (void)
 	{
 		daq_board[id].node = cat1("");
 		daq_board[id].is_real = 0;
+		daq_board[id].is_virtual = 0;
 		daq_board[id].is_connected = 0;
 		daq_board[id].scan_timer = timer_new();
+		mem_pool_init(&daq_board[id].scan_pool, M2_DAQ_POOL_HUGEPAGES, M2_DAQ_POOL_PREFAULT);
 
 		daq_board[id].info_driver     = cat1("∅");
 		daq_board[id].info_full_node  = cat1("∅");
@@ -170,8 +248,18 @@ void daq_init (void)
 		daq_board[id].info_output     = cat1("∅");
 		daq_board[id].info_input      = cat1("∅");
 		daq_board[id].info_settle     = cat1("∅");
+		daq_board[id].info_point      = cat1("∅");
+
+		for (int chan = 0; chan < M2_DAQ_MAX_CHAN; chan++)
+		{
+			daq_board[id].ai.ch[chan].owner = daq_board[id].ao.ch[chan].owner = NULL;
+			daq_board[id].ai.ch[chan].owner_size = daq_board[id].ao.ch[chan].owner_size = 0;
+			daq_board[id].ai.ch[chan].N_owner = daq_board[id].ao.ch[chan].N_owner = 0;
+		}
 #if COMEDI
 		daq_board[id].multi_insnlist.insns = daq_board[id].multi_insn;
+		daq_board[id].ao_insnlist.insns = daq_board[id].ao_insn;
+		daq_board[id].bg_raw = NULL;
 #endif
 	}
 
@@ -194,6 +282,11 @@ void daq_final (void)
 		replace(daq_board[id].info_output,     NULL);
 		replace(daq_board[id].info_input,      NULL);
 		replace(daq_board[id].info_settle,     NULL);
+		replace(daq_board[id].info_point,      NULL);
+
+		for (int chan = 0; chan < M2_DAQ_MAX_CHAN; chan++) free(daq_board[id].ai.ch[chan].owner);
+
+		mem_pool_final(&daq_board[id].scan_pool);
 	}
 }
 
@@ -201,6 +294,8 @@ void daq_board_close (struct DaqBoard *board)
 {
 	f_start(F_UPDATE);
 
+	background_stop(board);
+
 	if (board->is_real && board->is_connected)
 	{
 #if COMEDI
@@ -227,10 +322,22 @@ int daq_board_connect (int id, const char *node, int settle)
 	// multi setup:
 	daq_board[id].multi_N_chan = 0;
 	daq_board[id].multi_settle = settle;
+	daq_board[id].bg_avg = 0;
+	replace(daq_board[id].info_point, cat1("On demand"));
+
+	// batched AO writes:
+	for (int chan = 0; chan < M2_DAQ_MAX_CHAN; chan++) daq_board[id].ao_pending[chan] = 0;
+	daq_board[id].ao_N_pending = 0;
 
 	// scan setup:
 	daq_board[id].scan_prepared = 0;
+	daq_board[id].scan_armed = 0;
 	daq_board[id].scan_buffer = NULL;
+	daq_board[id].scan_t0 = 0;
+	daq_board[id].scan_t0_err = 0;
+	daq_board[id].scan_t_offset = 0;
+
+	daq_board[id].is_virtual = 0;
 
 	if (str_equal(node, "dummy"))
 	{
@@ -243,6 +350,28 @@ int daq_board_connect (int id, const char *node, int settle)
 		replace(daq_board[id].info_board_abrv, cat1("<Virt.>"));
 		replace(daq_board[id].info_settle,     cat1("N/A"));
 	}
+	else if (strncmp(node, "virtual", 7) == 0)
+	{
+		daq_board[id].is_real = 0;
+		daq_board[id].is_virtual = 1;
+		daq_board[id].is_connected = virtual_parse(&daq_board[id].vdev, node);
+
+		replace(daq_board[id].info_driver,    cat1("Virtual"));
+		replace(daq_board[id].info_full_node, cat1(node));
+		replace(daq_board[id].info_settle,    supercat("%d µs", daq_board[id].multi_settle*10));
+
+		if (daq_board[id].is_connected)
+		{
+			replace(daq_board[id].info_board, supercat("<Simulated> (%g kS/s, %ld B buffer, %g V noise)",
+			                                           daq_board[id].vdev.rate_kHz, (long) daq_board[id].vdev.buffer_size, daq_board[id].vdev.noise));
+			replace(daq_board[id].info_board_abrv, cat1("<Sim.>"));
+		}
+		else
+		{
+			replace(daq_board[id].info_board, supercat("Unusable option string \"%s\".", node));
+			replace(daq_board[id].info_board_abrv, cat1("∅"));
+		}
+	}
 	else
 	{
 		daq_board[id].is_real = 1;
@@ -323,7 +452,7 @@ int daq_board_connect (int id, const char *node, int settle)
 	subdevice_connect(&daq_board[id], &daq_board[id].ao, DAQ_AO);
 	subdevice_connect(&daq_board[id], &daq_board[id].ai, DAQ_AI);
 
-	if (daq_board[id].is_real)
+	if (daq_board[id].is_real || daq_board[id].is_virtual)
 	{
 		replace(daq_board[id].info_output, (daq_board[id].ao.N_ch > 0) ? supercat("%d ch [%0.1f, %0.1f]", daq_board[id].ao.N_ch, daq_board[id].ao.ch[0].min, daq_board[id].ao.ch[0].max) : cat1("0 ch"));
 		replace(daq_board[id].info_input,  (daq_board[id].ai.N_ch > 0) ? supercat("%d ch [%0.1f, %0.1f]", daq_board[id].ai.N_ch, daq_board[id].ai.ch[0].min, daq_board[id].ai.ch[0].max) : cat1("0 ch"));
@@ -344,6 +473,7 @@ void subdevice_connect (struct DaqBoard *board, struct SubDevice *subdev, int ty
 	for (int chan = 0; chan < M2_DAQ_MAX_CHAN; chan++)
 	{
 		subdev->ch[chan].req = 0;
+		subdev->ch[chan].N_owner = 0;
 		subdev->ch[chan].voltage = 0.0;
 		subdev->ch[chan].known = (type == DAQ_AO) ? 2 : 0;
 	}
@@ -431,6 +561,15 @@ void subdevice_connect (struct DaqBoard *board, struct SubDevice *subdev, int ty
 			}
 #endif
 		}
+		else if (board->is_virtual)
+		{
+			subdev->N_ch = (type == DAQ_AO) ? board->vdev.N_ao : board->vdev.N_ai;
+			for (int chan = 0; chan < subdev->N_ch; chan++)
+			{
+				subdev->ch[chan].min = -M2_DAQ_VIRTUAL_RANGE;
+				subdev->ch[chan].max =  M2_DAQ_VIRTUAL_RANGE;
+			}
+		}
 		else
 		{
 			subdev->N_ch = (type == DAQ_AO) ? M2_DAQ_VIRTUAL_NUM_DAC : M2_DAQ_VIRTUAL_NUM_ADC;
@@ -473,6 +612,7 @@ char * daq_board_info (int id, const char *info)
 	else if (str_equal(info, "output"))     return daq_board[id].info_output;
 	else if (str_equal(info, "input"))      return daq_board[id].info_input;
 	else if (str_equal(info, "settle"))     return daq_board[id].info_settle;
+	else if (str_equal(info, "point"))      return daq_board[id].info_point;
 	else                                    return cat1("∅");
 }
 
@@ -20,6 +20,20 @@
 
 #include <config.h>
 
+typedef struct
+{
+	long N_read, N_poll;    // device reads, buffer level checks
+	long N_retry;           // extra reads daq_SCAN_stop() needed to collect the last samples
+	long N_overrun;         // device buffer overflows (data lost)
+	long N_missing;         // samples never collected (underrun)
+	double peak_fill;       // fraction of the device buffer, or -1 if unknown (overrun margin = 1 - peak_fill)
+	double bytes_per_read;  // mean
+	double read_latency, read_latency_max;  // seconds spent in daq_SCAN_read(), mean and max
+	double throughput;      // samples/s collected, from trigger to stop
+	double process_time;    // seconds, set by scan_array_process()
+
+} ScanStats;
+
 typedef struct
 {
 	// input:
@@ -32,7 +46,9 @@ typedef struct
 	// output:
 	int status;
 	long N_pt;
-	double read_interval;
+	double read_interval;  // nominal time between reads (see daq_SCAN_poll())
+	double t_offset;       // start time relative to the first board released, set by scan_array_start()
+	ScanStats stats;       // set by scan_array_stop()
 
 } Scan;
 
@@ -51,20 +67,48 @@ int daq_AI_valid (int id, int chan);
 
 int daq_AO_read  (int id, int chan, double *voltage);
 int daq_AI_read  (int id, int chan, double *voltage);  // if unknown, add to multi setup
+int daq_AI_hold  (int id, int chan, const void *owner);  // see below
 int daq_AO_write (int id, int chan, double  voltage);
 
-int  daq_multi_tick  (int id);
-void daq_multi_reset (int id);
+void daq_AO_batch_begin  (void);  // hold daq_AO_write() calls on all boards (visible to daq_AO_read() right away) ...
+int  daq_AO_batch_commit (void);  // ... and issue them here, one transaction per board
+
+void daq_AI_release (const void *owner);  // drops owner's holds on every board, and channels nobody holds from the multi setup
+
+int  daq_multi_tick       (int id);
+void daq_multi_reset      (int id);
+void daq_multi_background (int id, int N_avg);  // N_avg > 0: sample continuously, readings average the latest N_avg scans
 
 // scans
 
 void   daq_SCAN_prepare (int id, Scan *userscan);
-int    daq_SCAN_start   (int id);
+int    daq_SCAN_arm     (int id);  // allocate buffer and load command, but do not start
+int    daq_SCAN_trigger (int id);  // release an armed scan and measure its start time
+int    daq_SCAN_start   (int id);  // arm + trigger
 double daq_SCAN_elapsed (int id);
 long   daq_SCAN_read    (int id);
+long   daq_SCAN_poll    (int id);  // read only once the device buffer reaches M2_DAQ_SCAN_WATERMARK
 long   daq_SCAN_stop    (int id);
+void   daq_SCAN_stats   (int id, ScanStats *stats);
+
+double daq_SCAN_t0    (int id);                // start time on the common clock
+double daq_SCAN_align (int id, double t_ref);  // set (and return) offset of this board's timebase from t_ref
 
 int daq_AO_convert (int id, int chan, long pt, double *voltage);
 int daq_AI_convert (int id, int chan, long pt, double *voltage);
 
+int daq_AO_resample (int id, int chan, double t, double *voltage);  // t on the aligned timebase
+int daq_AI_resample (int id, int chan, double t, double *voltage);  // t on the aligned timebase, interpolates
+
+// Notes on daq_AI_hold():
+//
+//   daq_AI_read() adds a channel to its board's multi setup (the comedi insn
+//   list, NI-DAQ scan list, or DAQmx task read on every daq_multi_tick()) the
+//   first time it is asked for. An owner (in practice, the ComputeFunc of a
+//   channel, trigger line, or sweep) that holds the channel lets go of it with
+//   daq_AI_release() before it is re-parsed, and a channel held by nobody is
+//   taken out of the multi setup, so the cost of each tick follows the
+//   channels still in use. Channels read without a holder stay until
+//   daq_multi_reset(), which also drops every hold.
+
 #endif
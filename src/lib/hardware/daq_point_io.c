@@ -32,7 +32,13 @@ void daq_multi_reset (int id)
 	f_verify(id >= 0 && id < M2_DAQ_MAX_BRD, DAQ_ID_WARNING_MSG, return);
 	f_verify(daq_board[id].is_connected,     NULL,               return);
 
-	for (int chan = 0; chan < M2_DAQ_MAX_CHAN; chan++) daq_board[id].ai.ch[chan].req = 0;
+	background_stop(&daq_board[id]);
+
+	for (int chan = 0; chan < M2_DAQ_MAX_CHAN; chan++)
+	{
+		daq_board[id].ai.ch[chan].req = 0;
+		daq_board[id].ai.ch[chan].N_owner = 0;
+	}
 	daq_board[id].multi_N_chan = 0;
 
 #if NIDAQMX	
@@ -48,6 +54,8 @@ int daq_multi_tick (int id)
 	// not connected (w/ chan):  do nothing,                 return 0 (failure)
 	// no driver:                do nothing,                 return 1 (success)
 	// dummy:                    set voltages to sine waves, return ?
+	// virtual:                  simulate conversions,       return 1
+	// background:               average latest scans,       return ?
 	// ------------------------------------------------------------------------
 
 	f_verify(id >= 0 && id < M2_DAQ_MAX_BRD, DAQ_ID_WARNING_MSG, return 0);
@@ -55,6 +63,8 @@ int daq_multi_tick (int id)
 	f_verify(daq_board[id].is_connected,     NULL,               return 0);
 
 	struct DaqBoard *board = &daq_board[id];
+	if (board->bg_running) return background_tick(board) ? 1 : 0;  // cost no longer depends on channel count or settling
+
 	if (board->is_real)
 	{
 #if COMEDI
@@ -85,6 +95,18 @@ int daq_multi_tick (int id)
 #endif
 		}
 	}
+	else if (board->is_virtual)
+	{
+		xleep(board->multi_N_chan * (2 * board->vdev.convert_time + board->multi_settle * 10e-6));  // same cost as the comedi insn list: read + wait(s) + read
+
+		double t = timer_elapsed(global_timer);
+		for (int pci = 0; pci < board->multi_N_chan; pci++)
+		{
+			int chan = board->multi_chan[pci];
+			board->ai.ch[chan].known = 1;
+			board->ai.ch[chan].voltage = virtual_to_phys(virtual_digitize(board, chan, t));
+		}
+	}
 	else
 	{
 		double t = timer_elapsed(global_timer);
@@ -108,6 +130,7 @@ int daq_AI_read (int id, int chan, double *voltage)
 	// bad chan:       complain,           return 0
 	// no driver:      add to MS, tick MS, return ?
 	// dummy:          add to MS, tick MS, return ?
+	// virtual:        add to MS, tick MS, return ?
 	// ------------------------------------------------------
 
 	f_verify(id >= 0 && id < M2_DAQ_MAX_BRD,            DAQ_ID_WARNING_MSG, return 0);
@@ -116,79 +139,70 @@ int daq_AI_read (int id, int chan, double *voltage)
 
 	if (!daq_board[id].ai.ch[chan].req)
 	{
-		struct DaqBoard *board = &daq_board[id];
-
 		// add this chan to multi config
-		board->ai.ch[chan].req = 1;
+		daq_board[id].ai.ch[chan].req = 1;
+		multi_rebuild(&daq_board[id]);
 
-		// regen multi config
-		board->multi_N_chan = 0;
-		for (int c = 0; c < board->ai.N_ch; c++)
-			if (board->ai.ch[c].req)
-				board->multi_chan[board->multi_N_chan++] = c;
+		daq_multi_tick(id);  // get complete set of values for immediate use
+	}
 
-		if (board->is_real && board->multi_N_chan > 0)
-		{
-#if COMEDI
-			int inc = board->multi_settle + 2;
-			for (int pci = 0; pci < board->multi_N_chan; pci++)
-			{
-				board->multi_insn[pci*inc].insn     = INSN_READ;
-				board->multi_insn[pci*inc].n        = 0;
-				board->multi_insn[pci*inc].subdev   = (unsigned int) board->ai.num;
-				board->multi_insn[pci*inc].chanspec = CR_PACK((unsigned int) board->multi_chan[pci], board->ai.range, AREF_GROUND);
-				board->multi_insn[pci*inc].data     = &dev_null;
+	*voltage = daq_board[id].ai.ch[chan].voltage;
+	return daq_board[id].ai.ch[chan].known;
+}
 
-				for (int s = 1; s <= board->multi_settle; s++)
-				{
-					board->multi_insn[pci*inc + s].insn = INSN_WAIT;
-					board->multi_insn[pci*inc + s].n    = 1;
-					board->multi_insn[pci*inc + s].data = &ten_us_in_ns;
-				}
+int daq_AI_hold (int id, int chan, const void *owner)
+{
+	// ------------------------------------------------------
+	// bad id:         complain,   return 0 (failure)
+	// not connected:  do nothing, return 0
+	// bad chan:       do nothing, return 0 (daq_AI_read() complains)
+	// ------------------------------------------------------
 
-				board->multi_insn[pci*inc + board->multi_settle + 1].insn     = INSN_READ;  // second time around should be more accurate now that the (multiplexed) ADC has settled
-				board->multi_insn[pci*inc + board->multi_settle + 1].n        = 1;
-				board->multi_insn[pci*inc + board->multi_settle + 1].subdev   = (unsigned int) board->ai.num;
-				board->multi_insn[pci*inc + board->multi_settle + 1].chanspec = CR_PACK((unsigned int) board->multi_chan[pci], board->ai.range, AREF_GROUND);
-				board->multi_insn[pci*inc + board->multi_settle + 1].data     = &board->multi_raw[pci];
-			}
-			board->multi_insnlist.n_insns = (unsigned int) (board->multi_N_chan * inc);  // board->multi_insnlist.insns already set to board->multi_insn
-#elif NIDAQ
-			int inc = board->multi_settle + 1;
-			i16 local_phys_chan[M2_DAQ_MAX_CHAN * inc], local_phys_gain[M2_DAQ_MAX_CHAN * inc];
-			for (int pci = 0; pci < board->multi_N_chan; pci++)
-			{
-				for (int s = 0; s <= board->multi_settle; s++)
-				{
-					local_phys_chan[pci*inc + s] = (i16) board->multi_chan[pci];
-					local_phys_gain[pci*inc + s] = NIDAQ_ADC_GAIN;
-				}
-			}
-			SCAN_Setup(board->nidaq_num, (i16) (board->multi_N_chan * inc), local_phys_chan, local_phys_gain);
-#elif NIDAQMX
+	f_verify(id >= 0 && id < M2_DAQ_MAX_BRD,            DAQ_ID_WARNING_MSG, return 0);
+	f_verify(daq_board[id].is_connected,                NULL,               return 0);
+	f_verify(chan >= 0 && chan < daq_board[id].ai.N_ch, NULL,               return 0);
 
-			mention_mx_error(DAQmxClearTask(board->multi_task));
-			create_mx_scan(&board->multi_task, board->node, -1, 1, board->multi_N_chan, board->multi_chan);
+	struct AnalogChannel *ch = &daq_board[id].ai.ch[chan];
+	for (int i = 0; i < ch->N_owner; i++) if (ch->owner[i] == owner) return 1;
 
-			float64 conv_rate = -1, conv_max_rate = -1;
-			mention_mx_error(DAQmxGetAIConvRate(board->multi_task, &conv_rate));
-			mention_mx_error(DAQmxGetAIConvMaxRate(board->multi_task, &conv_max_rate));
-			if (conv_rate > 0 && conv_max_rate > 0)
+	if (ch->N_owner == ch->owner_size)
+	{
+		ch->owner_size = (ch->owner_size > 0) ? 2 * ch->owner_size : 4;
+		ch->owner = realloc(ch->owner, (size_t) ch->owner_size * sizeof(const void *));
+	}
+	ch->owner[ch->N_owner++] = owner;
+
+	return 1;
+}
+
+void daq_AI_release (const void *owner)
+{
+	for (int id = 0; id < M2_DAQ_MAX_BRD; id++) if (daq_board[id].is_connected)
+	{
+		struct DaqBoard *board = &daq_board[id];
+
+		bool dropped = 0;
+		for (int chan = 0; chan < board->ai.N_ch; chan++)
+		{
+			struct AnalogChannel *ch = &board->ai.ch[chan];
+			for (int i = 0; i < ch->N_owner; i++) if (ch->owner[i] == owner)
 			{
-				double tau = 1.0 / conv_max_rate + board->multi_settle * 10e-6;
-				if (mention_mx_error(DAQmxSetAIConvRate(board->multi_task, 1.0 / tau)) == 0)
-					status_add(1, supercat("ADC conversion time changed from %1.1f µs to %1.1f µs.\n", 1e6 / conv_rate, 1e6 * tau));
+				ch->owner[i] = ch->owner[--ch->N_owner];  // order does not matter
+				if (ch->N_owner == 0 && ch->req)
+				{
+					ch->req = 0;  // nobody reads it anymore, so stop converting and settling it
+					dropped = 1;
+				}
+				break;
 			}
-
-			mention_mx_error(DAQmxStartTask(board->multi_task));  // starts task so it will be ready for OnDemand reads in the future
-#endif
 		}
 
-		daq_multi_tick(id);  // get complete set of values for immediate use
+		if (dropped)
+		{
+			multi_rebuild(board);
+			f_print(F_UPDATE, "Info: DAQ%d point reads now cover %d channel(s).\n", id, board->multi_N_chan);
+		}
 	}
-
-	*voltage = daq_board[id].ai.ch[chan].voltage;
-	return daq_board[id].ai.ch[chan].known;
 }
 
 int daq_AO_read (int id, int chan, double *voltage)
@@ -223,26 +237,404 @@ int daq_AO_write (int id, int chan, double voltage)
 	f_verify(voltage >= daq_board[id].ao.ch[chan].min &&
 	         voltage <= daq_board[id].ao.ch[chan].max,  DAQ_VOLTAGE_WARNING_MSG, return 0);
 
-	bool rv = 1;
-	if (daq_board[id].is_real)
+	struct DaqBoard *board = &daq_board[id];
+
+	if (ao_batching)
+	{
+		if (!board->ao_pending[chan]) board->ao_N_pending++;
+		board->ao_pending[chan] = 1;
+
+		board->ao.ch[chan].known = 1;  // until daq_AO_batch_commit() says otherwise
+		board->ao.ch[chan].voltage = voltage;
+		return 1;
+	}
+
+	bool rv = ao_write_now(board, chan, voltage);
+	if (rv)
+	{
+		board->ao.ch[chan].known = 1;
+		board->ao.ch[chan].voltage = voltage;
+	}
+
+	return rv ? 1 : 0;
+}
+
+bool ao_write_now (struct DaqBoard *board, int chan, double voltage)
+{
+	if (board->is_real)
 	{
 #if COMEDI
-		lsampl_t raw = comedi_from_phys(voltage, daq_board[id].ao.ch[chan].crange, daq_board[id].ao.ch[chan].maxdata);
-		rv = (comedi_data_write(daq_board[id].comedi_dev, (unsigned int) daq_board[id].ao.num, (unsigned int) chan, daq_board[id].ao.range, AREF_GROUND, raw) == 1);
+		lsampl_t raw = comedi_from_phys(voltage, board->ao.ch[chan].crange, board->ao.ch[chan].maxdata);
+		return (comedi_data_write(board->comedi_dev, (unsigned int) board->ao.num, (unsigned int) chan, board->ao.range, AREF_GROUND, raw) == 1);
 #elif NIDAQ
-		rv = (AO_VWrite(daq_board[id].nidaq_num, (i16) chan, voltage) == 0);
+		return (AO_VWrite(board->nidaq_num, (i16) chan, voltage) == 0);
 #elif NIDAQMX
-		rv = (mention_mx_error(DAQmxWriteAnalogScalarF64(daq_board[id].ao.ch[chan].task, 1, 0, voltage, NULL)) == 0);
+		return (mention_mx_error(DAQmxWriteAnalogScalarF64(board->ao.ch[chan].task, 1, 0, voltage, NULL)) == 0);
 #else
-		rv = 0;
+		return 0;
 #endif
 	}
+	else return 1;
+}
 
-	if (rv)
+void daq_AO_batch_begin (void)
+{
+	ao_batching = 1;
+}
+
+int daq_AO_batch_commit (void)
+{
+	// ------------------------------------------------------------------
+	// nothing pending:    do nothing,                        return 1 (success)
+	// write(s) failed:    complain, mark channel(s) unknown, return 0 (failure)
+	// ------------------------------------------------------------------
+
+	ao_batching = 0;
+
+	bool rv = 1;
+	for (int id = 0; id < M2_DAQ_MAX_BRD; id++)
+		if (daq_board[id].is_connected && daq_board[id].ao_N_pending > 0 && !ao_commit(&daq_board[id]))
+		{
+			status_add(0, supercat("Warning: Batched DAC write failed on DAQ%d.\n", id));
+			rv = 0;
+		}
+
+	return rv ? 1 : 0;
+}
+
+bool ao_commit (struct DaqBoard *board)
+{
+	bool rv = 1;
+	if (board->is_real)
 	{
-		daq_board[id].ao.ch[chan].known = 1;
-		daq_board[id].ao.ch[chan].voltage = voltage;
+#if COMEDI
+		// all channels in one comedi_do_insnlist(), so they update within microseconds of each other
+		unsigned int n = 0;
+		for (int chan = 0; chan < board->ao.N_ch; chan++) if (board->ao_pending[chan])
+		{
+			board->ao_raw[n] = comedi_from_phys(board->ao.ch[chan].voltage, board->ao.ch[chan].crange, board->ao.ch[chan].maxdata);
+
+			board->ao_insn[n].insn     = INSN_WRITE;
+			board->ao_insn[n].n        = 1;
+			board->ao_insn[n].subdev   = (unsigned int) board->ao.num;
+			board->ao_insn[n].chanspec = CR_PACK((unsigned int) chan, board->ao.range, AREF_GROUND);
+			board->ao_insn[n].data     = &board->ao_raw[n];
+			n++;
+		}
+		board->ao_insnlist.n_insns = n;  // board->ao_insnlist.insns already set to board->ao_insn
+
+		rv = (comedi_do_insnlist(board->comedi_dev, &board->ao_insnlist) == (int) n);
+		if (!rv) for (int chan = 0; chan < board->ao.N_ch; chan++) if (board->ao_pending[chan]) board->ao.ch[chan].known = 0;
+#else
+		// no multi-channel point write here, so just issue them back to back
+		for (int chan = 0; chan < board->ao.N_ch; chan++)
+			if (board->ao_pending[chan] && !ao_write_now(board, chan, board->ao.ch[chan].voltage))
+			{
+				board->ao.ch[chan].known = 0;
+				rv = 0;
+			}
+#endif
 	}
 
-	return rv ? 1 : 0;
+	for (int chan = 0; chan < M2_DAQ_MAX_CHAN; chan++) board->ao_pending[chan] = 0;
+	board->ao_N_pending = 0;
+
+	return rv;
+}
+
+void multi_rebuild (struct DaqBoard *board)
+{
+	board->multi_N_chan = 0;
+	for (int c = 0; c < board->ai.N_ch; c++)
+		if (board->ai.ch[c].req)
+			board->multi_chan[board->multi_N_chan++] = c;
+
+	multi_setup(board);
+}
+
+void multi_setup (struct DaqBoard *board)
+{
+	// regenerates the driver's view of the multi config, after multi_chan or bg_avg change
+
+	background_stop(board);
+
+	if (board->is_real && board->multi_N_chan > 0)
+	{
+#if COMEDI
+		int inc = board->multi_settle + 2;
+		for (int pci = 0; pci < board->multi_N_chan; pci++)
+		{
+			board->multi_insn[pci*inc].insn     = INSN_READ;
+			board->multi_insn[pci*inc].n        = 0;
+			board->multi_insn[pci*inc].subdev   = (unsigned int) board->ai.num;
+			board->multi_insn[pci*inc].chanspec = CR_PACK((unsigned int) board->multi_chan[pci], board->ai.range, AREF_GROUND);
+			board->multi_insn[pci*inc].data     = &dev_null;
+
+			for (int s = 1; s <= board->multi_settle; s++)
+			{
+				board->multi_insn[pci*inc + s].insn = INSN_WAIT;
+				board->multi_insn[pci*inc + s].n    = 1;
+				board->multi_insn[pci*inc + s].data = &ten_us_in_ns;
+			}
+
+			board->multi_insn[pci*inc + board->multi_settle + 1].insn     = INSN_READ;  // second time around should be more accurate now that the (multiplexed) ADC has settled
+			board->multi_insn[pci*inc + board->multi_settle + 1].n        = 1;
+			board->multi_insn[pci*inc + board->multi_settle + 1].subdev   = (unsigned int) board->ai.num;
+			board->multi_insn[pci*inc + board->multi_settle + 1].chanspec = CR_PACK((unsigned int) board->multi_chan[pci], board->ai.range, AREF_GROUND);
+			board->multi_insn[pci*inc + board->multi_settle + 1].data     = &board->multi_raw[pci];
+		}
+		board->multi_insnlist.n_insns = (unsigned int) (board->multi_N_chan * inc);  // board->multi_insnlist.insns already set to board->multi_insn
+#elif NIDAQ
+		int inc = board->multi_settle + 1;
+		i16 local_phys_chan[M2_DAQ_MAX_CHAN * inc], local_phys_gain[M2_DAQ_MAX_CHAN * inc];
+		for (int pci = 0; pci < board->multi_N_chan; pci++)
+		{
+			for (int s = 0; s <= board->multi_settle; s++)
+			{
+				local_phys_chan[pci*inc + s] = (i16) board->multi_chan[pci];
+				local_phys_gain[pci*inc + s] = NIDAQ_ADC_GAIN;
+			}
+		}
+		SCAN_Setup(board->nidaq_num, (i16) (board->multi_N_chan * inc), local_phys_chan, local_phys_gain);
+#elif NIDAQMX
+
+		mention_mx_error(DAQmxClearTask(board->multi_task));
+		create_mx_scan(&board->multi_task, board->node, -1, 1, board->multi_N_chan, board->multi_chan);
+
+		float64 conv_rate = -1, conv_max_rate = -1;
+		mention_mx_error(DAQmxGetAIConvRate(board->multi_task, &conv_rate));
+		mention_mx_error(DAQmxGetAIConvMaxRate(board->multi_task, &conv_max_rate));
+		if (conv_rate > 0 && conv_max_rate > 0)
+		{
+			double tau = 1.0 / conv_max_rate + board->multi_settle * 10e-6;
+			if (mention_mx_error(DAQmxSetAIConvRate(board->multi_task, 1.0 / tau)) == 0)
+				status_add(1, supercat("ADC conversion time changed from %1.1f µs to %1.1f µs.\n", 1e6 / conv_rate, 1e6 * tau));
+		}
+
+		if (board->bg_avg > 0)  // continuous and hardware-timed, with reads always returning the latest bg_avg scans
+		{
+			mention_mx_error(DAQmxCfgSampClkTiming(board->multi_task, "OnboardClock", M2_DAQ_BACKGROUND_RATE_KHZ * 1e3, DAQmx_Val_Rising, DAQmx_Val_ContSamps, (uInt64) (M2_DAQ_BACKGROUND_RATE_KHZ * 1e3)));
+			mention_mx_error(DAQmxSetReadOverWrite(board->multi_task, DAQmx_Val_OverwriteUnreadSamps));
+			mention_mx_error(DAQmxSetReadRelativeTo(board->multi_task, DAQmx_Val_MostRecentSamp));
+			mention_mx_error(DAQmxSetReadOffset(board->multi_task, -board->bg_avg));
+		}
+
+		mention_mx_error(DAQmxStartTask(board->multi_task));  // starts task so it will be ready for OnDemand reads in the future
+#endif
+	}
+
+	background_start(board);
+}
+
+void daq_multi_background (int id, int N_avg)
+{
+	// ----------------------------------------------
+	// bad id:         complain,   return
+	// bad N_avg:      complain,   return
+	// not connected:  do nothing, return
+	// dummy:          do nothing, return
+	// ----------------------------------------------
+
+	f_verify(id >= 0 && id < M2_DAQ_MAX_BRD,       DAQ_ID_WARNING_MSG,                                return);
+	f_verify(N_avg >= 0 && N_avg <= M2_DAQ_MAX_AVG, "Warning: Requested averaging value out of range.\n", return);
+	f_verify(daq_board[id].is_connected,           NULL,                                              return);
+	f_verify(daq_board[id].is_real || daq_board[id].is_virtual, NULL,                                 return);
+	f_start(F_UPDATE);
+
+	struct DaqBoard *board = &daq_board[id];
+
+#if NIDAQ
+	if (board->is_real && N_avg > 0)
+	{
+		status_add(0, supercat("Warning: Background sampling is not supported by Traditional NI-DAQ, using on-demand reads on DAQ%d.\n", id));
+		N_avg = 0;
+	}
+#endif
+
+	board->bg_avg = N_avg;
+	replace(board->info_point, N_avg > 0 ? supercat("Background (%d scan avg. at %g kHz)", N_avg, M2_DAQ_BACKGROUND_RATE_KHZ) : cat1("On demand"));
+
+	multi_setup(board);
+}
+
+void background_start (struct DaqBoard *board)
+{
+	board->bg_index = 0;
+	board->bg_filled = 0;
+
+	if (board->bg_avg == 0 || board->multi_N_chan == 0 || !board->is_connected) return;
+
+	if (board->is_real)
+	{
+#if COMEDI
+		for (int pci = 0; pci < board->multi_N_chan; pci++)
+			board->bg_chanlist[pci] = CR_PACK((unsigned int) board->multi_chan[pci], board->ai.range, AREF_GROUND);
+
+		unsigned int scan_ns = (unsigned int) (1e6 / M2_DAQ_BACKGROUND_RATE_KHZ);
+
+		board->bg_cmd.subdev         = (unsigned int) board->ai.num;
+		board->bg_cmd.flags          = 0;
+		board->bg_cmd.chanlist       = board->bg_chanlist;
+		board->bg_cmd.chanlist_len   = (unsigned int) board->multi_N_chan;
+		board->bg_cmd.start_src      = TRIG_NOW;
+		board->bg_cmd.start_arg      = 0;
+		board->bg_cmd.scan_begin_src = TRIG_TIMER;
+		board->bg_cmd.scan_begin_arg = scan_ns;
+		board->bg_cmd.convert_src    = TRIG_TIMER;
+		board->bg_cmd.convert_arg    = (unsigned int) max_int((int) scan_ns / board->multi_N_chan, board->multi_settle * 10000);  // honor settling between conversions
+		board->bg_cmd.scan_end_src   = TRIG_COUNT;
+		board->bg_cmd.scan_end_arg   = (unsigned int) board->multi_N_chan;
+		board->bg_cmd.stop_src       = TRIG_NONE;
+		board->bg_cmd.stop_arg       = 0;
+
+		int crv = 0;
+		for (int i = 0; i < 4; i++)  // 3 or 4 means arguments were adjusted, so test again
+			if ((crv = comedi_command_test(board->comedi_dev, &board->bg_cmd)) != 3 && crv != 4) break;
+
+		board->bg_raw = malloc((size_t) (board->ai.buffer_size + board->multi_N_chan * board->ai.b_sampl));
+		board->bg_partial = 0;
+
+		if (crv == 0 && board->bg_raw != NULL && comedi_command(board->comedi_dev, &board->bg_cmd) == 0)
+		{
+			board->bg_running = 1;
+			f_print(F_VERBOSE, "Background sampling at %1.3f kHz, %d ns per conversion.\n", 1e6 / board->bg_cmd.scan_begin_arg, board->bg_cmd.convert_arg);
+		}
+		else
+		{
+			replace(board->bg_raw, NULL);
+			status_add(1, supercat("Warning: Cannot start background sampling (comedi_command_test() returned %d), using on-demand reads.\n", crv));
+		}
+#elif NIDAQMX
+		board->bg_running = 1;  // multi_task already configured and started by multi_setup()
+#endif
+	}
+	else if (board->is_virtual)
+	{
+		board->bg_t_last = timer_elapsed(global_timer);
+		board->bg_running = 1;
+	}
+}
+
+void background_stop (struct DaqBoard *board)
+{
+	if (!board->bg_running) return;
+	board->bg_running = 0;
+
+	if (board->is_real)
+	{
+#if COMEDI
+		comedi_cancel(board->comedi_dev, (unsigned int) board->ai.num);
+		replace(board->bg_raw, NULL);
+#elif NIDAQMX
+		mention_mx_error(DAQmxStopTask(board->multi_task));
+#endif
+	}
+}
+
+bool background_read (struct DaqBoard *board)
+{
+	// pushes newly acquired scans (at most bg_avg of them) into bg_ring
+
+	long N_new = 0;
+	double scan[M2_DAQ_MAX_AVG][M2_DAQ_MAX_CHAN];
+
+	if (board->is_real)
+	{
+#if COMEDI
+		ssize_t b_scan = board->multi_N_chan * board->ai.b_sampl;
+		ssize_t b_avail = min_long(comedi_get_buffer_contents(board->comedi_dev, (unsigned int) board->ai.num), board->ai.buffer_size);
+		ssize_t b_read = (b_avail > 0) ? read(comedi_fileno(board->comedi_dev), (char *) board->bg_raw + board->bg_partial, (size_t) b_avail) : b_avail;
+
+		if (b_read < 0)  // most likely a buffer overflow, which ends the command
+		{
+			f_print(F_WARNING, "Warning: Background sampling interrupted, restarting.\n");
+			background_stop(board);
+			background_start(board);
+			return board->bg_running;
+		}
+
+		ssize_t b_total = board->bg_partial + b_read;
+		long N_scan = b_total / b_scan;
+		for (long k = max_long(N_scan - board->bg_avg, 0); k < N_scan; k++, N_new++)
+			for (int pci = 0; pci < board->multi_N_chan; pci++)
+			{
+				int chan = board->multi_chan[pci];
+				char *ptr = (char *) board->bg_raw + k * b_scan + pci * board->ai.b_sampl;
+
+				lsampl_t raw;
+				if (board->ai.use_lsampl) memcpy(&raw, ptr, sizeof(lsampl_t));
+				else
+				{
+					sampl_t raw_short;
+					memcpy(&raw_short, ptr, sizeof(sampl_t));
+					raw = raw_short;
+				}
+
+				scan[N_new][pci] = comedi_to_phys(raw, board->ai.ch[chan].crange, board->ai.ch[chan].maxdata);
+			}
+
+		board->bg_partial = b_total - N_scan * b_scan;
+		memmove(board->bg_raw, (char *) board->bg_raw + N_scan * b_scan, (size_t) board->bg_partial);
+#elif NIDAQMX
+		uInt64 total = 0;
+		mention_mx_error(DAQmxGetReadTotalSampPerChanAcquired(board->multi_task, &total));
+
+		if (total >= (uInt64) board->bg_avg)  // otherwise the read (relative to the most recent scan) would block
+		{
+			int32 spc_read = 0;
+			if (mention_mx_error(DAQmxReadAnalogF64(board->multi_task, board->bg_avg, 0.0, DAQmx_Val_GroupByScanNumber, board->multi_voltage,
+			                                        (uInt32) (M2_DAQ_MAX_CHAN * M2_DAQ_MAX_AVG), &spc_read, NULL)) != 0) return 0;
+
+			board->bg_index = board->bg_filled = 0;  // every read returns the full window
+			for (; N_new < spc_read; N_new++)
+				for (int pci = 0; pci < board->multi_N_chan; pci++)
+					scan[N_new][pci] = board->multi_voltage[N_new * board->multi_N_chan + pci];
+		}
+#endif
+	}
+	else if (board->is_virtual)
+	{
+		double period = max_double(1e-3 / M2_DAQ_BACKGROUND_RATE_KHZ, board->multi_N_chan * 1e-3 / board->vdev.rate_kHz);
+		long N_scan = floor_long((timer_elapsed(global_timer) - board->bg_t_last) / period);
+
+		for (long k = max_long(N_scan - board->bg_avg, 0); k < N_scan; k++, N_new++)
+			for (int pci = 0; pci < board->multi_N_chan; pci++)
+				scan[N_new][pci] = virtual_to_phys(virtual_digitize(board, board->multi_chan[pci], board->bg_t_last + (double) (k + 1) * period));
+
+		board->bg_t_last += (double) N_scan * period;
+	}
+
+	for (long k = 0; k < N_new; k++)
+	{
+		for (int pci = 0; pci < board->multi_N_chan; pci++) board->bg_ring[board->bg_index][pci] = scan[k][pci];
+		board->bg_index = (board->bg_index + 1) % board->bg_avg;
+		board->bg_filled = min_int(board->bg_filled + 1, board->bg_avg);
+	}
+
+	return 1;
+}
+
+bool background_tick (struct DaqBoard *board)
+{
+	double t_start = timer_elapsed(global_timer);
+
+	if (!background_read(board)) return 0;
+	while (board->bg_filled == 0)  // just (re)started
+	{
+		if (timer_elapsed(global_timer) - t_start > M2_DAQ_BACKGROUND_TIMEOUT) return 0;
+		xleep(0.1 / (M2_DAQ_BACKGROUND_RATE_KHZ * 1e3));
+		if (!background_read(board)) return 0;
+	}
+
+	for (int pci = 0; pci < board->multi_N_chan; pci++)
+	{
+		double sum = 0;
+		for (int k = 0; k < board->bg_filled; k++) sum += board->bg_ring[k][pci];
+
+		int chan = board->multi_chan[pci];
+		board->ai.ch[chan].known = 1;
+		board->ai.ch[chan].voltage = sum / board->bg_filled;
+	}
+
+	return 1;
 }
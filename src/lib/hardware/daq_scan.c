@@ -15,56 +15,138 @@
  *  program. If not, see <http://www.gnu.org/licenses/>.
 */
 
-int daq_SCAN_start (int id)
+int daq_SCAN_arm (int id)
 {
-	// not prepared:  do nothing, return 0 (failure)
-	// no driver:     do nothing, return 1 (success)
-	// dummy:         do nothing, return 1
+	// not prepared:  do nothing,                       return 0 (failure)
+	// no driver:     do nothing,                       return 1 (success)
+	// dummy:         allocate buffer,                  return 1
+	// virtual:       reset simulated device buffer,    return 1
 
 	f_verify(id >= 0 && id < M2_DAQ_MAX_BRD, DAQ_ID_WARNING_MSG,      return 0);
 	f_verify(daq_board[id].is_connected,     DAQ_CONNECT_WARNING_MSG, return 0);
 
 	struct DaqBoard *board = &daq_board[id];
+	board->scan_armed = 0;
 
 	if (board->scan_prepared)
 	{
-		timer_reset(board->scan_timer);
+		background_stop(board);  // frees the AI subdevice, restarted by daq_SCAN_stop()
+
+		board->scan_peak_fill = 0;
+		board->scan_N_read = 0;
+		board->scan_N_poll = 0;
+		board->scan_N_retry = 0;
+		board->scan_N_overrun = 0;
+		board->scan_read_bytes = 0;
+		board->scan_read_time = 0;
+		board->scan_read_time_max = 0;
+		board->scan_duration = 0;
 
 		if (board->is_real)
 		{
 #if COMEDI
-			board->scan_buffer = malloc((size_t) (board->scan_total * board->ai.b_sampl));
-			return (board->scan_buffer != NULL && comedi_command(board->comedi_dev, &board->scan_cmd) == 0) ? 1 : 0;
+			board->scan_buffer = mem_pool_get(&board->scan_pool, (size_t) (board->scan_total * board->ai.b_sampl));
+			if (board->scan_buffer == NULL) return 0;
+			if (board->scan_int_trig && comedi_command(board->comedi_dev, &board->scan_cmd) != 0) return 0;  // waits for comedi_internal_trigger()
 #elif NIDAQ
-			board->scan_buffer = malloc((size_t) board->scan_total * sizeof(i16));
+			board->scan_buffer = mem_pool_get(&board->scan_pool, (size_t) board->scan_total * sizeof(i16));
 			if (board->scan_buffer == NULL) return 0;
 
 			SCAN_Setup(board->nidaq_num, (i16) board->scan_N_chan, board->scan_phys_chan, board->scan_phys_gain);
 			DAQ_Config(board->nidaq_num, 0, 0);  // internal trigger and clock
-
-			return (SCAN_Start(board->nidaq_num, (i16*) board->scan_buffer, (u32) board->scan_total,
-		                       board->scan_tbcode, board->scan_sample_t, board->scan_tbcode, 0) == 0) ? 1 : 0;
 #elif NIDAQMX
 			mention_mx_error(DAQmxStopTask(board->multi_task));  // pause multi_task, which naturally conflicts with scan_task
-			board->scan_buffer = malloc((size_t) board->scan_total * sizeof(float64));
-			return (board->scan_buffer != NULL && mention_mx_error(DAQmxStartTask(board->scan_task)) == 0) ? 1 : 0;
-#else
-			return 1;
+			board->scan_buffer = mem_pool_get(&board->scan_pool, (size_t) board->scan_total * sizeof(float64));
+			if (board->scan_buffer == NULL) return 0;
+			if (mention_mx_error(DAQmxTaskControl(board->scan_task, DAQmx_Val_Task_Commit)) != 0) return 0;  // so DAQmxStartTask() is quick
 #endif
 		}
+		else if (board->is_virtual)
+		{
+			board->vdev.overrun = 0;
+			board->scan_buffer = mem_pool_get(&board->scan_pool, (size_t) board->scan_total * sizeof(uint16_t));
+			if (board->scan_buffer == NULL) return 0;
+		}
 		else
 		{
-			board->scan_buffer = malloc((size_t) board->scan_total * sizeof(double));
-			return 1;
+			board->scan_buffer = mem_pool_get(&board->scan_pool, (size_t) board->scan_total * sizeof(double));
+			if (board->scan_buffer == NULL) return 0;
 		}
+
+		board->scan_armed = 1;
+		return 1;
 	}
 	else return 0;
 }
 
+int daq_SCAN_trigger (int id)
+{
+	// not armed:  do nothing,                 return 0 (failure)
+	// no driver:  record start time,          return 1 (success)
+	// dummy:      record start time,          return 1
+	// virtual:    record start time,          return 1
+
+	f_verify(id >= 0 && id < M2_DAQ_MAX_BRD, DAQ_ID_WARNING_MSG,      return 0);
+	f_verify(daq_board[id].is_connected,     DAQ_CONNECT_WARNING_MSG, return 0);
+	f_verify(daq_board[id].scan_armed,       NULL,                    return 0);
+
+	struct DaqBoard *board = &daq_board[id];
+	board->scan_armed = 0;
+
+	bool rv = 1;
+	double t_before = timer_elapsed(global_timer);
+
+	if (board->is_real)
+	{
+#if COMEDI
+		rv = board->scan_int_trig ? (comedi_internal_trigger(board->comedi_dev, (unsigned int) board->ai.num, 0) == 0) :
+		                            (comedi_command(board->comedi_dev, &board->scan_cmd) == 0);  // TRIG_NOW
+#elif NIDAQ
+		rv = (SCAN_Start(board->nidaq_num, (i16*) board->scan_buffer, (u32) board->scan_total,
+		                 board->scan_tbcode, board->scan_sample_t, board->scan_tbcode, 0) == 0);
+#elif NIDAQMX
+		rv = (mention_mx_error(DAQmxStartTask(board->scan_task)) == 0);
+#endif
+	}
+
+	double t_after = timer_elapsed(global_timer);
+	timer_reset(board->scan_timer);
+
+	board->scan_t0     = 0.5 * (t_before + t_after);
+	board->scan_t0_err = 0.5 * (t_after - t_before);
+	board->scan_t_offset = 0;
+	board->scan_next_poll = board->scan_read_interval;  // nothing worth reading before then
+
+	return rv ? 1 : 0;
+}
+
+int daq_SCAN_start (int id)
+{
+	return (daq_SCAN_arm(id) == 1 && daq_SCAN_trigger(id) == 1) ? 1 : 0;
+}
+
+double daq_SCAN_t0 (int id)
+{
+	f_verify(id >= 0 && id < M2_DAQ_MAX_BRD, DAQ_ID_WARNING_MSG, return 0);
+
+	return daq_board[id].scan_t0;
+}
+
+double daq_SCAN_align (int id, double t_ref)
+{
+	f_verify(id >= 0 && id < M2_DAQ_MAX_BRD, DAQ_ID_WARNING_MSG, return 0);
+
+	daq_board[id].scan_t_offset = daq_board[id].scan_t0 - t_ref;
+	f_print(F_BENCH, "DAQ%d: start offset: %1.3f ± %1.3f ms\n", id, 1e3 * daq_board[id].scan_t_offset, 1e3 * daq_board[id].scan_t0_err);
+
+	return daq_board[id].scan_t_offset;
+}
+
 void daq_SCAN_prepare (int id, Scan *userscan)
 {
 	// no driver:              do nothing,      return 0 (failure)
 	// dummy:                  prepare scan,    return 1 (success)
+	// virtual:                same as comedi
 	// rate needs adjustment:  update rate_kHz, return 4 (try again)
 
 	userscan->status = 0;
@@ -77,8 +159,10 @@ void daq_SCAN_prepare (int id, Scan *userscan)
 
 	struct DaqBoard *board = &daq_board[id];
 
-	replace(board->scan_buffer, NULL);
+	board->scan_buffer = NULL;  // owned by scan_pool
 	board->scan_prepared = 0;
+	board->scan_armed = 0;
+	board->scan_buffer_size = 0;
 
 	if (userscan->N_chan == 0) return;
 
@@ -108,11 +192,14 @@ void daq_SCAN_prepare (int id, Scan *userscan)
 		for (int pci = 0; pci < userscan->N_chan; pci++)
 			board->scan_chanlist[pci] = CR_PACK((unsigned int) userscan->phys_chan[pci], board->ai.range, AREF_GROUND);
 
+		comedi_cmd src_mask;
+		board->scan_int_trig = (comedi_get_cmd_src_mask(board->comedi_dev, (unsigned int) board->ai.num, &src_mask) == 0) && (src_mask.start_src & TRIG_INT);
+
 		board->scan_cmd.subdev         = (unsigned int) board->ai.num;
 		board->scan_cmd.flags          = 0;
 		board->scan_cmd.chanlist       = board->scan_chanlist;
 		board->scan_cmd.chanlist_len   = (unsigned int) userscan->N_chan;
-		board->scan_cmd.start_src      = TRIG_NOW;
+		board->scan_cmd.start_src      = board->scan_int_trig ? TRIG_INT : TRIG_NOW;
 		board->scan_cmd.start_arg      = 0;
 		board->scan_cmd.scan_begin_src = TRIG_TIMER;
 		board->scan_cmd.scan_begin_arg = (unsigned int) (1e9 / (userscan->rate_kHz * 1e3));
@@ -126,7 +213,10 @@ void daq_SCAN_prepare (int id, Scan *userscan)
 		int crv = comedi_command_test(board->comedi_dev, &board->scan_cmd);
 		if (crv == 0)
 		{
-			userscan->read_interval = board->ai.buffer_size / (userscan->rate_kHz * 4e3 * (double) (userscan->N_chan * board->ai.b_sampl));  // 4e3 = safety factor * Hz/kHz
+			board->scan_b_sampl = board->ai.b_sampl;
+			board->scan_buffer_size = board->ai.buffer_size;
+			board->scan_byte_rate = userscan->rate_kHz * 1e3 * (double) (userscan->N_chan * board->ai.b_sampl);
+			userscan->read_interval = M2_DAQ_SCAN_WATERMARK * (double) board->scan_buffer_size / board->scan_byte_rate;
 			// rate_kHz unchanged...
 			board->scan_prepared = 1;
 			userscan->status = 1;
@@ -165,6 +255,7 @@ void daq_SCAN_prepare (int id, Scan *userscan)
 		{
 			userscan->rate_kHz = 1.0 / (userscan->N_chan * timebase * board->scan_sample_t * 1e3);
 			userscan->read_interval = 1.0;
+			board->scan_b_sampl = (ssize_t) sizeof(i16);
 
 			userscan->N_pt = (long) (userscan->total_time * userscan->rate_kHz * 1e3);    // compute for the first time
 			userscan->total_time = (double) userscan->N_pt / (userscan->rate_kHz * 1e3);  // recompute due to possible rounding
@@ -187,7 +278,10 @@ void daq_SCAN_prepare (int id, Scan *userscan)
 		{
 		    mention_mx_error(DAQmxCfgInputBuffer(board->scan_task, (uInt32) (userscan->rate_kHz * 4e3)));  // four seconds worth
 
-			userscan->read_interval = 1.0;  // one second (safety factor of 4)
+			board->scan_b_sampl = (ssize_t) sizeof(float64);
+			board->scan_buffer_size = (ssize_t) (userscan->rate_kHz * 4e3) * userscan->N_chan * (ssize_t) sizeof(float64);
+			board->scan_byte_rate = userscan->rate_kHz * 1e3 * (double) (userscan->N_chan * (int) sizeof(float64));
+			userscan->read_interval = M2_DAQ_SCAN_WATERMARK * (double) board->scan_buffer_size / board->scan_byte_rate;
 			// rate_kHz unchanged...
 
 			board->scan_prepared = 1;
@@ -196,6 +290,31 @@ void daq_SCAN_prepare (int id, Scan *userscan)
 		else status_add(0, cat1("Warning: DAQmx setup error.\n"));
 #endif
 	}
+	else if (board->is_virtual)
+	{
+		// emulate comedi_command_test(): integer nanosecond convert timer, limited by the aggregate rate
+		double convert_ns = max_double(floor(1e9 / (userscan->N_chan * userscan->rate_kHz * 1e3) + 0.5), ceil(1e6 / board->vdev.rate_kHz));
+		double rate_kHz = 1e9 / (userscan->N_chan * convert_ns * 1e3);
+
+		if (fabs(rate_kHz - userscan->rate_kHz) <= 1e-9 * rate_kHz)
+		{
+			for (int pci = 0; pci < userscan->N_chan; pci++) board->vdev.scan_chan[pci] = userscan->phys_chan[pci];
+
+			board->scan_b_sampl = (ssize_t) sizeof(uint16_t);
+			board->scan_buffer_size = board->vdev.buffer_size;
+			board->scan_byte_rate = userscan->rate_kHz * 1e3 * (double) (userscan->N_chan * (int) sizeof(uint16_t));
+			userscan->read_interval = M2_DAQ_SCAN_WATERMARK * (double) board->scan_buffer_size / board->scan_byte_rate;
+			// rate_kHz unchanged...
+			board->scan_prepared = 1;
+			userscan->status = 1;
+		}
+		else
+		{
+			userscan->rate_kHz = rate_kHz;
+			// rate_kHz changed, user should try again...
+			userscan->status = 4;
+		}
+	}
 	else 
 	{
 		for (int pci = 0; pci < userscan->N_chan; pci++)
@@ -205,11 +324,14 @@ void daq_SCAN_prepare (int id, Scan *userscan)
 		}
 
 		userscan->read_interval = 0.5;  // half second for smoother testing runs
+		board->scan_b_sampl = (ssize_t) sizeof(double);
 		// rate_kHz unchanged...
 
 		board->scan_prepared = 1;
 		userscan->status = 1;
 	}
+
+	board->scan_read_interval = userscan->read_interval;
 }
 
 double daq_SCAN_elapsed (int id)
@@ -224,11 +346,13 @@ long daq_SCAN_read (int id)
 {
 	// no driver:  do nothing,      return 0
 	// dummy:      update progress, return # of samples read
+	// virtual:    drain simulated device buffer, return # of samples read (0 after an overrun)
 
 	f_verify(id >= 0 && id < M2_DAQ_MAX_BRD, DAQ_ID_WARNING_MSG, return 0);
 	f_verify(daq_board[id].is_connected,     NULL,               return 0);
 
 	struct DaqBoard *board = &daq_board[id];
+	double t_start = timer_elapsed(board->scan_timer);
 
 	long s_read = 0;
 	if (board->is_real)
@@ -236,8 +360,10 @@ long daq_SCAN_read (int id)
 #if COMEDI
 		ssize_t b_avail = comedi_get_buffer_contents(board->comedi_dev, (unsigned int) board->ai.num);
 		ssize_t b_read_1 = 0, b_read_2 = 0;
+		board->scan_peak_fill = max_long(board->scan_peak_fill, b_avail);
 
-		if (b_avail <= board->scan_total * board->ai.b_sampl)
+		if (b_avail < 0) board->scan_N_overrun++;  // comedi reports a buffer overflow as an error
+		else if (b_avail <= board->scan_total * board->ai.b_sampl)
 		{
 			if (board->ai.use_lsampl)
 			{
@@ -256,6 +382,13 @@ long daq_SCAN_read (int id)
 		}
 		else f_print(F_WARNING, "Warning: Device buffer has more bytes than expected.\n");
 
+		if (b_read_1 < 0 || b_read_2 < 0)  // EPIPE: overflow since the last read
+		{
+			board->scan_N_overrun++;
+			b_read_1 = max_long(b_read_1, 0);
+			b_read_2 = max_long(b_read_2, 0);
+		}
+
 		s_read = (b_read_1 + b_read_2) / board->ai.b_sampl;  // # of samples read
 
 		f_print(F_RUN, "Info: Read (%d+%d)/%d bytes.\n", b_read_1, b_read_2, b_avail);
@@ -273,12 +406,47 @@ long daq_SCAN_read (int id)
 #elif NIDAQMX
 		int32 spc_read;
 		float64 *buffer = board->scan_buffer;
-		mention_mx_error(DAQmxReadAnalogF64(daq_board[id].scan_task, -1, -1, DAQmx_Val_GroupByScanNumber, buffer + board->scan_offset, (uInt32) board->scan_total, &spc_read, NULL));
+		if (mention_mx_error(DAQmxReadAnalogF64(daq_board[id].scan_task, -1, -1, DAQmx_Val_GroupByScanNumber, buffer + board->scan_offset, (uInt32) board->scan_total, &spc_read, NULL)) == DAQmxErrorSamplesNoLongerAvailable)
+			board->scan_N_overrun++;
 		s_read = spc_read * board->scan_N_chan;
+		board->scan_peak_fill = max_long(board->scan_peak_fill, s_read * (ssize_t) sizeof(float64));
 
 		f_print(F_RUN, "Info: Read %ld/%ld samples.\n", s_read, s_read);
 #endif
 	}
+	else if (board->is_virtual)
+	{
+		// If more samples have accumulated than fit in the device buffer,
+		// the acquisition is aborted just as comedi does on a buffer overflow.
+
+		struct VirtualDevice *vdev = &board->vdev;
+		long s_conv = virtual_converted(board);
+		ssize_t b_avail = (s_conv - board->scan_offset) * (ssize_t) sizeof(uint16_t);
+
+		if (!vdev->overrun && b_avail > vdev->buffer_size)
+		{
+			vdev->overrun = 1;
+			board->scan_N_overrun++;
+			status_add(1, supercat("Warning: Virtual DAQ%d buffer overrun (%ld > %ld bytes), scan aborted.\n", id, (long) b_avail, (long) vdev->buffer_size));
+		}
+
+		if (!vdev->overrun)
+		{
+			board->scan_peak_fill = max_long(board->scan_peak_fill, b_avail);
+
+			uint16_t *buffer = board->scan_buffer;
+			long N_pt = board->scan_total / board->scan_N_chan;
+			for (long j = board->scan_offset; j < s_conv; j++)
+			{
+				int pci = (int) (j % board->scan_N_chan);
+				double t = board->scan_t0 + (double) (j / board->scan_N_chan) / (double) N_pt * board->scan_total_time;  // global_timer, like daq_multi_tick()
+				buffer[j] = (uint16_t) virtual_digitize(board, vdev->scan_chan[pci], t);
+				s_read++;
+			}
+
+			f_print(F_RUN, "Info: Read %ld bytes (peak fill %ld/%ld).\n", (long) b_avail, (long) board->scan_peak_fill, (long) vdev->buffer_size);
+		}
+	}
 	else
 	{
 		long ret = min_long((long) ((double) board->scan_total * timer_elapsed(board->scan_timer) / board->scan_total_time), board->scan_total);
@@ -300,9 +468,84 @@ long daq_SCAN_read (int id)
 
 	board->scan_offset += s_read;
 	board->scan_saved = board->scan_offset / board->scan_N_chan;  // round down
+
+	double t_read = timer_elapsed(board->scan_timer) - t_start;
+	board->scan_N_read++;
+	board->scan_read_bytes += (double) (s_read * board->scan_b_sampl);
+	board->scan_read_time += t_read;
+	board->scan_read_time_max = max_double(board->scan_read_time_max, t_read);
+
 	return s_read;
 }
 
+long daq_SCAN_poll (int id)
+{
+	// buffer level known:    read once it reaches the watermark, otherwise come back when it should have
+	// buffer level unknown:  read every read_interval
+
+	f_verify(id >= 0 && id < M2_DAQ_MAX_BRD, DAQ_ID_WARNING_MSG, return 0);
+	f_verify(daq_board[id].is_connected,     NULL,               return 0);
+
+	struct DaqBoard *board = &daq_board[id];
+
+	double t = timer_elapsed(board->scan_timer);
+	if (t < board->scan_next_poll) return 0;
+
+	board->scan_N_poll++;
+	ssize_t b_fill = scan_fill(board);
+	double b_mark = M2_DAQ_SCAN_WATERMARK * (double) board->scan_buffer_size;
+
+	long s_read = 0;
+	if (b_fill < 0 || (double) b_fill >= b_mark)
+	{
+		s_read = daq_SCAN_read(id);
+		if (b_fill >= 0) b_fill = 0;  // drained
+	}
+
+	board->scan_next_poll = t + ((b_fill >= 0) ? (b_mark - (double) b_fill) / board->scan_byte_rate : board->scan_read_interval);
+	return s_read;
+}
+
+ssize_t scan_fill (struct DaqBoard *board)
+{
+	// returns bytes waiting in the device buffer, or -1 if unknown
+
+	if (board->scan_buffer_size <= 0) return -1;
+
+	if (board->is_real)
+	{
+#if COMEDI
+		return comedi_get_buffer_contents(board->comedi_dev, (unsigned int) board->ai.num);
+#elif NIDAQMX
+		uInt32 spc_avail;
+		if (mention_mx_error(DAQmxGetReadAvailSampPerChan(board->scan_task, &spc_avail)) != 0) return -1;
+		return (ssize_t) spc_avail * board->scan_N_chan * (ssize_t) sizeof(float64);
+#endif
+	}
+	else if (board->is_virtual) return (virtual_converted(board) - board->scan_offset) * (ssize_t) sizeof(uint16_t);
+
+	return -1;
+}
+
+void daq_SCAN_stats (int id, ScanStats *stats)
+{
+	f_verify(id >= 0 && id < M2_DAQ_MAX_BRD, DAQ_ID_WARNING_MSG, return);
+
+	struct DaqBoard *board = &daq_board[id];
+
+	stats->N_read    = board->scan_N_read;
+	stats->N_poll    = board->scan_N_poll;
+	stats->N_retry   = board->scan_N_retry;
+	stats->N_overrun = board->scan_N_overrun;
+	stats->N_missing = board->scan_total - board->scan_offset;
+	stats->peak_fill = (board->scan_buffer_size > 0) ? (double) board->scan_peak_fill / (double) board->scan_buffer_size : -1;
+
+	stats->bytes_per_read   = (board->scan_N_read > 0) ? board->scan_read_bytes / (double) board->scan_N_read : 0;
+	stats->read_latency     = (board->scan_N_read > 0) ? board->scan_read_time  / (double) board->scan_N_read : 0;
+	stats->read_latency_max = board->scan_read_time_max;
+	stats->throughput       = (board->scan_duration > 0) ? (double) board->scan_offset / board->scan_duration : 0;
+}
+
 long daq_SCAN_stop (int id)
 {
 	// no driver:  do nothing,    return 0
@@ -319,7 +562,9 @@ long daq_SCAN_stop (int id)
 		f_print(F_WARNING, "Warning: Waiting to obtain the last few(?) samples.\n");
 		xleep(M2_DAQ_EXTRA_SCAN_TIME / 8);
 		s_read += daq_SCAN_read(id);  // attempt to grab last of the data, again
+		board->scan_N_retry++;
 	}
+	board->scan_duration = timer_elapsed(board->scan_timer);
 
 	if (board->is_real)
 	{
@@ -333,6 +578,8 @@ long daq_SCAN_stop (int id)
 #endif
 	}
 
+	background_start(board);  // if enabled
+
 	return s_read;
 }
 
@@ -341,6 +588,7 @@ int daq_AI_convert (int id, int chan, long pt, double *voltage)
 	// absent chan:  do nothing,                 return 0 (failure)
 	// no driver:    do nothing,                 return 1 (success)
 	// dummy:        set voltage to a sine wave, return 1
+	// virtual:      work normally,              return 1
 
 	f_verify(id >= 0 && id < M2_DAQ_MAX_BRD,            DAQ_ID_WARNING_MSG, return 0);
 	f_verify(daq_board[id].is_connected,                NULL,               return 2);  // (unknown)
@@ -374,6 +622,11 @@ int daq_AI_convert (int id, int chan, long pt, double *voltage)
 			*voltage = buffer[pci + board->scan_N_chan * pt];  // already scaled
 #endif
 		}
+		else if (board->is_virtual)
+		{
+			uint16_t *buffer = board->scan_buffer;
+			*voltage = virtual_to_phys(buffer[pci + board->scan_N_chan * pt]);
+		}
 		else
 		{
 			double *buffer = board->scan_buffer;
@@ -397,3 +650,51 @@ int daq_AO_convert (int id, int chan, long pt, double *voltage)
 	*voltage = (pt < daq_board[id].scan_saved) ? daq_board[id].ao.ch[chan].voltage : 0.0;
 	return daq_board[id].ao.ch[chan].known;
 }
+
+int daq_AI_resample (int id, int chan, double t, double *voltage)
+{
+	// Like daq_AI_convert(), but at time t measured on the aligned timebase, i.e. from the start of the
+	// earliest board in the group. Interpolates linearly between this board's points.
+
+	f_verify(id >= 0 && id < M2_DAQ_MAX_BRD, DAQ_ID_WARNING_MSG, return 0);
+	f_verify(daq_board[id].is_connected,     NULL,               return 2);  // (unknown)
+	f_verify(daq_board[id].scan_N_chan > 0,  NULL,               return 0);
+
+	struct DaqBoard *board = &daq_board[id];
+
+	double x = (t - board->scan_t_offset) * (double) (board->scan_total / board->scan_N_chan) / board->scan_total_time;
+	if (fabs(x - floor(x + 0.5)) < 1e-6) x = floor(x + 0.5);  // exact hit, e.g. the reference board itself
+
+	if (x <= -1 || x >= board->scan_saved)  // outside of this board's (possibly interrupted) acquisition window
+	{
+		*voltage = 0;
+		return 1;
+	}
+
+	long pt = max_long(floor_long(x), 0);
+	double frac = (x > pt && pt + 1 < board->scan_saved) ? x - (double) pt : 0;  // hold first/last point at the edges
+
+	int rv = daq_AI_convert(id, chan, pt, voltage);
+	if (rv == 1 && frac > 0)
+	{
+		double next;
+		daq_AI_convert(id, chan, pt + 1, &next);
+		*voltage += frac * (next - *voltage);
+	}
+
+	return rv;
+}
+
+int daq_AO_resample (int id, int chan, double t, double *voltage)
+{
+	f_verify(id >= 0 && id < M2_DAQ_MAX_BRD,            DAQ_ID_WARNING_MSG, return 0);  // (failure)
+	f_verify(daq_board[id].is_connected,                NULL,               return 2);  // (unknown)
+	f_verify(chan >= 0 && chan < daq_board[id].ao.N_ch, NULL,               return 0);
+	f_verify(daq_board[id].scan_N_chan > 0,             NULL,               return 0);
+
+	struct DaqBoard *board = &daq_board[id];
+
+	double x = (t - board->scan_t_offset) * (double) (board->scan_total / board->scan_N_chan) / board->scan_total_time;
+	*voltage = (x > -1 && x < board->scan_saved) ? board->ao.ch[chan].voltage : 0.0;
+	return board->ao.ch[chan].known;
+}
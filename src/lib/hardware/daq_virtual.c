@@ -0,0 +1,117 @@
+/*
+ *  Copyright (C) 2012 California Institute of Technology
+ *
+ *  This file is part of Mezurit2, written by Brian Standley <brian@brianstandley.com>.
+ *
+ *  Mezurit2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Foundation,
+ *  either version 3 of the License, or (at your option) any later version.
+ *
+ *  Mezurit2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE. See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with this
+ *  program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+bool virtual_parse (struct VirtualDevice *vdev, const char *node)
+{
+	// node syntax:  "virtual" or "virtual:key=value,key=value,..."
+	// keys:         rate (aggregate kS/s), ai, ao, noise (V rms), latency (ms), convert (µs), buffer (bytes), seed
+
+	vdev->rate_kHz     = M2_DAQ_VIRTUAL_RATE_KHZ;
+	vdev->noise        = M2_DAQ_VIRTUAL_NOISE;
+	vdev->latency      = M2_DAQ_VIRTUAL_LATENCY;
+	vdev->convert_time = M2_DAQ_VIRTUAL_CONVERT_TIME;
+	vdev->N_ao         = M2_DAQ_VIRTUAL_NUM_DAC;
+	vdev->N_ai         = M2_DAQ_VIRTUAL_NUM_ADC;
+	vdev->buffer_size  = M2_DAQ_COMEDI_BUFFER_SIZE;
+	vdev->seed         = 1;
+
+	const char *p = &node[7];  // skip "virtual"
+	if      (*p == ':')  p++;
+	else if (*p != '\0') return 0;
+
+	while (*p != '\0')
+	{
+		char key[16];
+		double value;
+		int n = 0;
+		if (sscanf(p, "%15[^=]=%lf%n", key, &value, &n) != 2) return 0;
+		p += n;
+
+		if      (str_equal(key, "rate"))    vdev->rate_kHz     = value;
+		else if (str_equal(key, "noise"))   vdev->noise        = value;
+		else if (str_equal(key, "latency")) vdev->latency      = value * 1e-3;
+		else if (str_equal(key, "convert")) vdev->convert_time = value * 1e-6;
+		else if (str_equal(key, "ao"))      vdev->N_ao         = (int) value;
+		else if (str_equal(key, "ai"))      vdev->N_ai         = (int) value;
+		else if (str_equal(key, "buffer"))  vdev->buffer_size  = (ssize_t) value;
+		else if (str_equal(key, "seed"))    vdev->seed         = (uint32_t) value;
+		else return 0;
+
+		if      (*p == ',')  p++;
+		else if (*p != '\0') return 0;
+	}
+
+	vdev->rng = (vdev->seed != 0) ? vdev->seed : 1;  // xorshift state must be nonzero
+	vdev->overrun = 0;
+
+	return (vdev->rate_kHz > 0 && vdev->noise >= 0 && vdev->latency >= 0 && vdev->convert_time >= 0 &&
+	        vdev->N_ao >= 0 && vdev->N_ao <= M2_DAQ_MAX_CHAN && vdev->N_ai >= 0 && vdev->N_ai <= M2_DAQ_MAX_CHAN &&
+	        vdev->buffer_size >= (ssize_t) sizeof(uint16_t));
+}
+
+double virtual_gauss (struct VirtualDevice *vdev)
+{
+	// xorshift32 plus Box-Muller, so runs are reproducible for a given seed
+
+	double u[2];
+	for (int i = 0; i < 2; i++)
+	{
+		vdev->rng ^= vdev->rng << 13;
+		vdev->rng ^= vdev->rng >> 17;
+		vdev->rng ^= vdev->rng << 5;
+		u[i] = ((double) vdev->rng + 1.0) / 4294967296.0;  // (0, 1]
+	}
+
+	return sqrt(-2.0 * log(u[0])) * cos(2*U_PI * u[1]);
+}
+
+unsigned int virtual_digitize (struct DaqBoard *board, int chan, double t)
+{
+	// The DACs are looped back onto the first ADCs so that sweeps can be checked end to end.
+	// Remaining ADCs see 1 V test waveforms, like the dummy board.
+
+	double voltage;
+	if (chan < board->ao.N_ch) voltage = board->ao.ch[chan].voltage;
+	else
+	{
+		double wt = t * (chan / 3 + 1);
+		switch (chan % 3)
+		{
+			case 0  : voltage = sin(2 * U_PI * wt);               break;
+			case 1  : voltage = (wt - floor(wt) < 0.5) ? 1 : -1;  break;
+			default : voltage = 2 * (wt - floor(wt)) - 1;
+		}
+	}
+
+	if (board->vdev.noise > 0) voltage += board->vdev.noise * virtual_gauss(&board->vdev);
+
+	double raw = floor((voltage + M2_DAQ_VIRTUAL_RANGE) / (2 * M2_DAQ_VIRTUAL_RANGE) * M2_DAQ_VIRTUAL_MAXDATA + 0.5);
+	return (unsigned int) max_double(min_double(raw, M2_DAQ_VIRTUAL_MAXDATA), 0);  // clip, like a real converter
+}
+
+double virtual_to_phys (unsigned int raw)
+{
+	return (double) raw / M2_DAQ_VIRTUAL_MAXDATA * (2 * M2_DAQ_VIRTUAL_RANGE) - M2_DAQ_VIRTUAL_RANGE;
+}
+
+long virtual_converted (struct DaqBoard *board)
+{
+	// Samples appear at the scan rate after the conversion latency.
+
+	double t = timer_elapsed(board->scan_timer) - board->vdev.latency;
+	return max_long(min_long((long) (t / board->scan_total_time * (double) board->scan_total), board->scan_total), 0);
+}
@@ -17,8 +17,12 @@
 
 #include "gpib.h"
 
-#include <stdlib.h>  // free()
+#include <stdlib.h>  // free(), realloc(), strtod()
 #include <stdio.h>  // snprintf(), sscanf()
+#include <ctype.h>  // isdigit()
+#include <string.h>  // strstr(), strncmp(), strcspn(), memcpy(), memset()
+#include <stdint.h>
+#include <math.h>
 #define HEADER_SANS_WARNINGS <Python.h>
 #include <sans_warnings.h>
 
@@ -26,6 +30,9 @@
 #include <lib/pile.h>
 #include <lib/status.h>
 #include <lib/util/str.h>
+#include <lib/util/fs.h>
+#include <lib/util/num.h>
+#include <lib/util/mt.h>
 #include <lib/hardware/timing.h>
 
 #if LINUXGPIB
@@ -55,19 +62,90 @@ struct GpibSlot
 	PyObject *py_noninv_f, *py_inv_f;
 	int cmdlen;
 
-	Timer *timer;
-	double dt;
+	double dt;         // target period
+	int priority;      // when not every period can be met, higher priorities are polled first
+	double due;        // next deadline, on the board clock
+	double cost;       // measured time per query (moving average), negative until known
+	double send_time;  // time spent sending the query of the current round
+	double sent_at;    // when that query finished going out, on the board clock
+	long N_late;       // deadlines missed by a full period or more
+
+	double write_dt;                            // minimum time between setpoint writes
+	double write_next, write_next_global;       // earliest time for the next write, on the board clock
+	long N_write, N_write_merged;               // setpoints sent, and setpoints superseded before they could be
+
+	GpibSlotStats stats, stats_global;          // stats_global is copied from stats by gpib_multi_transfer()
+	long seq_window;                            // seq_local at the start of the board's stats window
+
+	const void **owner;                         // expressions reading the slot, see gpib_slot_hold(); none means suspended
+	int N_owner, owner_size;
+
+	char *group_prefix, *group_item, *group_sep;  // compound query description, NULL if none
+	struct GpibSlot *group_next;                  // other slots riding on this one's query
+
+	int parse_mode;              // GPIB_PARSE_*
+	int parse_a, parse_b;        // field offset and width, split index, or number index
+	char *parse_sep;             // split delimiter
+	bool affine;                 // convert natively, ignoring py_noninv_f and py_inv_f
+	double scale, offset;        // physical = scale * raw + offset
 
 	bool write_request_local, write_request_global;
 	bool known_local, known_global;
 	double current_local, current_global;
+	double t_local, t_global;  // when current_* was measured, on the board clock
+	long seq_local, seq_global;  // counts measurements
+
+};
+
+struct GpibHealth  // per device, used by the worker only
+{
+	int tmo;          // index into timeout_steps[], i.e., ibtmo() code - 1
+	double latency;   // end of query to end of reply (moving average), negative until known; see health_update()
+	int N_fail;       // consecutive failed queries
+	double retry_at;  // no polling before this time while failing, on the board clock
+	bool down;        // reported as not responding
+
+};
+
+enum { GPIB_PARSE_FORMAT, GPIB_PARSE_FIELD, GPIB_PARSE_SPLIT, GPIB_PARSE_NUMBER };
+
+enum { SIM_CONST, SIM_GAUSS, SIM_RAMP, SIM_SINE, SIM_REG, SIM_SET, SIM_MAP, SIM_TEXT, SIM_TIMEOUT };
+
+struct SimRule
+{
+	int pad;                 // -1 matches any device
+	char *cmd;               // matched against the start of each message
+	int cmdlen;
+	double latency, jitter;  // s, gaussian
+	int gen;                 // SIM_*
+	double p[3];
+	char *name;              // register name or map prefix
+	char *reply_fmt;
+
+};
+
+struct SimRegister
+{
+	int pad;
+	char *name;
+	double value;
+
+};
+
+struct SimBus  // simulated instruments, selected with a node string such as "sim" or "sim:script=bench.sim,seed=2"
+{
+	Pile rules, regs;
+	uint32_t rng;
+
+	char *query[M2_GPIB_MAX_PAD];  // last message sent to each device
+	double t_query[M2_GPIB_MAX_PAD];
 
 };
 
 struct GpibBoard
 {
 	char *node;
-	bool is_real, is_connected;
+	bool is_real, is_sim, is_connected;
 	int node_num;
 
 	char *info_driver, *info_full_node, *info_board, *info_board_abrv;
@@ -76,16 +154,71 @@ struct GpibBoard
 	int eos[M2_GPIB_MAX_PAD];
 
 	char buf[M2_GPIB_BUF_LENGTH + 1];
+	char cmd_buf[M2_GPIB_BUF_LENGTH + 1];  // compound queries
 	Pile slots;
+	MtMutex lock;  // protects slots and the "global" half of each slot
+
+	Timer *clock;              // scheduler time base
+	struct GpibSlot **queue;   // worker's snapshot of slots
+	struct GpibSlot **batch;   // queries sent, replies not yet collected
+	size_t queue_size;
+	bool overloaded;           // requested rates exceed the bus time available
+	bool interrupt;            // set by gpib_multi_interrupt(), protected by lock
+
+	GpibBoardStats stats, stats_global;
+	double busy, window_t0;    // bus time used since the start of the current stats window
+
+	struct GpibHealth health[M2_GPIB_MAX_PAD];
+
+	char *idn_cmd[M2_GPIB_MAX_PAD];  // identification query asked of each device, NULL if none, protected by lock
+	char *idn[M2_GPIB_MAX_PAD];      // its reply, NULL until gpib_device_identify() gets one
+
+	struct SimBus sim;
 
 };
 
 static struct GpibBoard gpib_board [M2_GPIB_MAX_BRD];
 
-static void gpib_device_connect (int id, int pad);
-static void free_slot_cb (struct GpibSlot *slot);
+static const double timeout_steps [] = { 10e-6, 30e-6, 100e-6, 300e-6, 1e-3, 3e-3, 10e-3, 30e-3, 100e-3, 300e-3, 1.0, 3.0, 10.0, 30.0, 100.0, 300.0, 1000.0 };  // T10us ... T1000s
+
+static void   gpib_device_connect (int id, int pad);
+static void   free_slot_cb        (struct GpibSlot *slot);
+static void * identify_thread     (void *data);
+
+static size_t coalesce (struct GpibBoard *board, struct GpibSlot *leader, double now, size_t N);
+static bool   parse_reply (struct GpibSlot *slot, const char *reply, double *x);
+static size_t snapshot    (struct GpibBoard *board);
+static void   send_write  (struct GpibBoard *board, int id, struct GpibSlot *slot);
+static void   stats_reset (struct GpibBoard *board);
+static double average     (double mean, double x);
+
+static void   health_reset  (struct GpibBoard *board, int pad);
+static void   health_update (int id, int pad, bool answered, double latency, double now);
+static double poll_timeout  (struct GpibHealth *health);
+static int    timeout_index (double timeout);
+static void   set_timeout   (int id, int pad, double timeout);
+
+static bool   query_send    (int id, int pad, char *cmd, int cmdlen);
+static char * query_receive (int id, int pad);
+#if LINUXGPIB || NI488
+static bool   query_wait    (int dev);
+#endif
+
+static bool             sim_parse        (struct SimBus *sim, const char *node);
+static bool             sim_add_rule     (struct SimBus *sim, const char *line);
+static char *           sim_unescape     (const char *str);
+static void             sim_clear        (struct SimBus *sim);
+static void             free_sim_rule_cb (struct SimRule *rule);
+static void             free_sim_reg_cb  (struct SimRegister *reg);
+static struct SimRule * sim_match        (struct SimBus *sim, int pad, const char *msg);
+static double *         sim_register     (struct SimBus *sim, int pad, const char *name, double init);
+static double           sim_gauss        (struct SimBus *sim);
+static double           sim_value        (struct SimBus *sim, struct SimRule *rule, int pad, double t);
+static void             sim_send         (struct GpibBoard *board, int pad, const char *cmd, int cmdlen);
+static long             sim_receive      (struct GpibBoard *board, int pad);
 
 #include "gpib_slot_io.c"
+#include "gpib_sim.c"
 
 void gpib_init (void)
 {
@@ -95,6 +228,7 @@ void gpib_init (void)
 	{
 		gpib_board[id].node = cat1("");
 		gpib_board[id].is_real = 0;
+		gpib_board[id].is_sim = 0;
 		gpib_board[id].is_connected = 0;
 
 		gpib_board[id].info_driver     = cat1("∅");
@@ -106,9 +240,24 @@ void gpib_init (void)
 		{
 			gpib_board[id].dev[pad] = -2;
 			gpib_board[id].eos[pad] = 0;
+			gpib_board[id].idn_cmd[pad] = NULL;
+			gpib_board[id].idn[pad] = NULL;
 		}
 
 		pile_init(&gpib_board[id].slots);
+		mt_mutex_init(&gpib_board[id].lock);
+
+		gpib_board[id].clock = timer_new();
+		gpib_board[id].queue = NULL;
+		gpib_board[id].batch = NULL;
+		gpib_board[id].queue_size = 0;
+		gpib_board[id].overloaded = 0;
+		gpib_board[id].interrupt = 0;
+		stats_reset(&gpib_board[id]);
+
+		pile_init(&gpib_board[id].sim.rules);
+		pile_init(&gpib_board[id].sim.regs);
+		for (int pad = 0; pad < M2_GPIB_MAX_PAD; pad++) gpib_board[id].sim.query[pad] = NULL;
 	}
 }
 
@@ -127,7 +276,22 @@ void gpib_final (void)
 		replace(gpib_board[id].info_board,      NULL);
 		replace(gpib_board[id].info_board_abrv, NULL);
 
+		for (int pad = 0; pad < M2_GPIB_MAX_PAD; pad++)
+		{
+			replace(gpib_board[id].idn_cmd[pad], NULL);
+			replace(gpib_board[id].idn[pad],     NULL);
+		}
+
 		pile_final(&gpib_board[id].slots, PILE_CALLBACK(free_slot_cb));
+		mt_mutex_clear(&gpib_board[id].lock);
+
+		timer_destroy(gpib_board[id].clock);
+
+		sim_clear(&gpib_board[id].sim);
+		pile_final(&gpib_board[id].sim.rules, PILE_CALLBACK(free_sim_rule_cb));
+		pile_final(&gpib_board[id].sim.regs,  PILE_CALLBACK(free_sim_reg_cb));
+		free(gpib_board[id].queue);
+		free(gpib_board[id].batch);
 	}
 }
 
@@ -136,12 +300,15 @@ int gpib_board_connect (int id, const char *node)
 	f_verify(id >= 0 && id < M2_GPIB_MAX_BRD, GPIB_ID_WARNING_MSG, return 0);
 	f_start(F_UPDATE);
 
-	// clear devices and slots:
+	// clear devices and slots, and forget who was there:
 	if (gpib_board[id].is_connected) gpib_board_reset(id);
+	gpib_device_forget(id, -1);
 
 	// update node:
 	replace(gpib_board[id].node, cat1(node));
 
+	gpib_board[id].is_sim = 0;
+
 	if (str_equal(node, "dummy"))
 	{
 		gpib_board[id].is_real = 0;
@@ -152,6 +319,18 @@ int gpib_board_connect (int id, const char *node)
 		replace(gpib_board[id].info_board,      cat1("<Virtual>"));
 		replace(gpib_board[id].info_board_abrv, cat1("<Virt.>"));
 	}
+	else if (strncmp(node, "sim", 3) == 0)
+	{
+		gpib_board[id].is_real = 0;
+		gpib_board[id].is_sim = 1;
+		gpib_board[id].is_connected = sim_parse(&gpib_board[id].sim, node);
+		timer_reset(gpib_board[id].clock);
+
+		replace(gpib_board[id].info_driver,     cat1("Simulated"));
+		replace(gpib_board[id].info_full_node,  cat1(node));
+		replace(gpib_board[id].info_board,      gpib_board[id].is_connected ? cat1("<Simulated bus>") : supercat("Failed to set up \"%s\".", node));
+		replace(gpib_board[id].info_board_abrv, cat1(gpib_board[id].is_connected ? "<Sim.>" : "∅"));
+	}
 	else
 	{
 		gpib_board[id].is_real = 1;
@@ -232,9 +411,22 @@ void gpib_board_reset (int id)
 
 		gpib_board[id].dev[pad] = -2;
 		gpib_board[id].eos[pad] = 0;
+
+		replace(gpib_board[id].sim.query[pad], NULL);
 	}
 
+	mt_mutex_lock(&gpib_board[id].lock);
 	pile_gc(&gpib_board[id].slots, PILE_CALLBACK(free_slot_cb));
+	gpib_board[id].overloaded = 0;
+	stats_reset(&gpib_board[id]);
+	mt_mutex_unlock(&gpib_board[id].lock);
+}
+
+int gpib_board_connected (int id)
+{
+	f_verify(id >= 0 && id < M2_GPIB_MAX_BRD, GPIB_ID_WARNING_MSG, return 0);
+
+	return gpib_board[id].is_connected ? 1 : 0;
 }
 
 char * gpib_board_info (int id, const char *info)
@@ -257,7 +449,7 @@ void gpib_device_connect (int id, int pad)
 	if (gpib_board[id].is_real)
 	{
 #if LINUXGPIB || NI488
-		gpib_board[id].dev[pad] = ibdev(gpib_board[id].node_num, pad, NO_SAD, T1s, 1, gpib_board[id].eos[pad]);
+		gpib_board[id].dev[pad] = ibdev(gpib_board[id].node_num, pad, NO_SAD, timeout_index(M2_GPIB_TIMEOUT) + 1, 1, gpib_board[id].eos[pad]);
 
 		if (gpib_board[id].dev[pad] >= 0) ibclr(gpib_board[id].dev[pad]);
 #else
@@ -266,6 +458,8 @@ void gpib_device_connect (int id, int pad)
 	}
 	else gpib_board[id].dev[pad] = pad;
 
+	health_reset(&gpib_board[id], pad);
+
 	if (gpib_board[id].dev[pad] < 0) status_add(0, supercat("Warning: Unable to connect to GPIB device %d via board %d.\n", pad, gpib_board[id].node_num));
 }
 
@@ -279,28 +473,204 @@ char * gpib_string_query (int id, int pad, char *cmd, int cmdlen, int expect_rep
 
 	if (gpib_board[id].dev[pad] >= 0)
 	{
-		long last = 0;
-		if (gpib_board[id].is_real)
+		set_timeout(id, pad, M2_GPIB_TIMEOUT);  // not the polling timeout, which is tailored to other commands
+		query_send(id, pad, cmd, cmdlen);
+
+		if (expect_reply != 0) return query_receive(id, pad);
+		else
+		{
+			gpib_board[id].buf[0] = '\0';
+			return gpib_board[id].buf;
+		}
+	}
+	else return NULL;
+}
+
+char * gpib_device_idn (int id, int pad, const char *cmd)
+{
+	f_verify(id >= 0 && id < M2_GPIB_MAX_BRD,   GPIB_ID_WARNING_MSG,      return NULL);
+	f_verify(gpib_board[id].is_connected,       GPIB_CONNECT_WARNING_MSG, return NULL);
+	f_verify(pad >= 0 && pad < M2_GPIB_MAX_PAD, GPIB_PAD_WARNING_MSG,     return NULL);
+
+	mt_mutex_lock(&gpib_board[id].lock);
+	char *idn = NULL;
+	if (str_equal(gpib_board[id].idn_cmd[pad], cmd))
+	{
+		if (gpib_board[id].idn[pad] != NULL) idn = cat1(gpib_board[id].idn[pad]);  // else still pending
+	}
+	else
+	{
+		replace(gpib_board[id].idn_cmd[pad], cat1(cmd));  // ask at the next gpib_device_identify()
+		replace(gpib_board[id].idn[pad],     NULL);
+	}
+	mt_mutex_unlock(&gpib_board[id].lock);
+
+	return idn;
+}
+
+void gpib_device_forget (int id, int pad)
+{
+	f_verify(id >= 0 && id < M2_GPIB_MAX_BRD, GPIB_ID_WARNING_MSG, return);
+
+	mt_mutex_lock(&gpib_board[id].lock);
+	for (int p = 0; p < M2_GPIB_MAX_PAD; p++) if (pad == -1 || pad == p)
+	{
+		replace(gpib_board[id].idn_cmd[p], NULL);
+		replace(gpib_board[id].idn[p],     NULL);
+	}
+	mt_mutex_unlock(&gpib_board[id].lock);
+}
+
+int gpib_device_identify (void)
+{
+	f_start(F_UPDATE);
+
+	Timer *timer _timerfree_ = timer_new();
+
+	MtThread thread[M2_GPIB_MAX_BRD];
+	for (int id = 0; id < M2_GPIB_MAX_BRD; id++)
+	{
+		bool pending = 0;
+
+		mt_mutex_lock(&gpib_board[id].lock);
+		for (int pad = 0; pad < M2_GPIB_MAX_PAD; pad++) if (gpib_board[id].idn_cmd[pad] != NULL && gpib_board[id].idn[pad] == NULL) pending = 1;
+		mt_mutex_unlock(&gpib_board[id].lock);
+
+		thread[id] = (gpib_board[id].is_connected && pending) ? mt_thread_create(identify_thread, &gpib_board[id]) : NULL;
+	}
+
+	int N = 0;
+	for (int id = 0; id < M2_GPIB_MAX_BRD; id++) if (thread[id] != NULL)
+	{
+		mt_thread_join(thread[id]);
+
+		mt_mutex_lock(&gpib_board[id].lock);
+		for (int pad = 0; pad < M2_GPIB_MAX_PAD; pad++) if (gpib_board[id].idn_cmd[pad] != NULL && gpib_board[id].idn[pad] == NULL)
 		{
+			f_print(F_WARNING, "Warning: GPIB device %d on board %d did not identify itself.\n", pad, id);
+			replace(gpib_board[id].idn_cmd[pad], NULL);  // ask again next time
+		}
+		else if (gpib_board[id].idn[pad] != NULL) N++;
+		mt_mutex_unlock(&gpib_board[id].lock);
+	}
+
+	if (N > 0) f_print(F_UPDATE, "Info: %d GPIB devices known after %0.3f s.\n", N, timer_elapsed(timer));
+
+	return N;
+}
+
+void * identify_thread (void *data)
+{
+	// Same idea as a polling round: every query goes out before any reply is read, so the devices think in parallel.
+
+	struct GpibBoard *board = data;
+	int id = (int) (board - gpib_board);
+
+	char *cmd[M2_GPIB_MAX_PAD];
+	mt_mutex_lock(&board->lock);
+	for (int pad = 0; pad < M2_GPIB_MAX_PAD; pad++) cmd[pad] = (board->idn_cmd[pad] != NULL && board->idn[pad] == NULL) ? cat1(board->idn_cmd[pad]) : NULL;
+	mt_mutex_unlock(&board->lock);
+
+	bool sent[M2_GPIB_MAX_PAD];
+	for (int pad = 0; pad < M2_GPIB_MAX_PAD; pad++) if (cmd[pad] != NULL)
+	{
+		if (board->dev[pad] == -2) gpib_device_connect(id, pad);
+		set_timeout(id, pad, M2_GPIB_TIMEOUT);
+		sent[pad] = query_send(id, pad, cmd[pad], str_length(cmd[pad]));
+	}
+
+	for (int pad = 0; pad < M2_GPIB_MAX_PAD; pad++) if (cmd[pad] != NULL)
+	{
+		char *reply = sent[pad] ? str_strip_end(query_receive(id, pad), "\n\r") : NULL;
+		bool known = (str_length(reply) > 0) || (sent[pad] && !board->is_real && !board->is_sim);  // dummy devices have nothing to say
+
+		mt_mutex_lock(&board->lock);
+		if (known && str_equal(board->idn_cmd[pad], cmd[pad])) replace(board->idn[pad], cat1(reply));  // unless forgotten meanwhile
+		mt_mutex_unlock(&board->lock);
+
+		free(reply);
+
+		free(cmd[pad]);
+	}
+
+	return NULL;
+}
+
+bool query_send (int id, int pad, char *cmd, int cmdlen)
+{
+	if (gpib_board[id].dev[pad] == -2) gpib_device_connect(id, pad);
+
+	if (gpib_board[id].dev[pad] < 0) return 0;
+	else if (gpib_board[id].is_sim)
+	{
+		sim_send(&gpib_board[id], pad, cmd, cmdlen);
+		return 1;
+	}
+	else if (!gpib_board[id].is_real) return 1;
+	else
+	{
 #if LINUXGPIB
-			ibwrt(gpib_board[id].dev[pad], cmd, cmdlen);
+		ibwrta(gpib_board[id].dev[pad], cmd, cmdlen);
+		return query_wait(gpib_board[id].dev[pad]);
 #elif NI488
-			ibwrt(gpib_board[id].dev[pad], (PVOID) cmd, cmdlen);
+		ibwrta(gpib_board[id].dev[pad], (PVOID) cmd, cmdlen);
+		return query_wait(gpib_board[id].dev[pad]);
+#else
+		return 0;
 #endif
+	}
+}
 
-			if (expect_reply != 0)
-			{
-#if LINUXGPIB || NI488
-				ibrd (gpib_board[id].dev[pad], gpib_board[id].buf, M2_GPIB_BUF_LENGTH);
-				last = ibcntl;
+char * query_receive (int id, int pad)
+{
+	long last = 0;
+	if (gpib_board[id].is_sim && gpib_board[id].dev[pad] >= 0) last = max_long(sim_receive(&gpib_board[id], pad), 0);
+	else if (gpib_board[id].is_real && gpib_board[id].dev[pad] >= 0)
+	{
+#if LINUXGPIB
+		ibrda(gpib_board[id].dev[pad], gpib_board[id].buf, M2_GPIB_BUF_LENGTH);
+		if (query_wait(gpib_board[id].dev[pad])) last = min_long(ibcntl, M2_GPIB_BUF_LENGTH);
+#elif NI488
+		ibrda(gpib_board[id].dev[pad], (PVOID) gpib_board[id].buf, M2_GPIB_BUF_LENGTH);
+		if (query_wait(gpib_board[id].dev[pad])) last = min_long(ibcntl, M2_GPIB_BUF_LENGTH);
 #endif
-			}
-		}
-		gpib_board[id].buf[last] = '\0';
+	}
+	gpib_board[id].buf[last] = '\0';
 
-		return gpib_board[id].buf;
+	return gpib_board[id].buf;
+}
+
+#if LINUXGPIB || NI488
+bool query_wait (int dev)
+{
+	int status = ibwait(dev, CMPL | TIMO);  // gives up after the device's own timeout
+	if (!(status & CMPL))
+	{
+		ibstop(dev);
+		return 0;
 	}
-	else return NULL;
+	else return !(status & ERR);
+}
+#endif
+
+int timeout_index (double timeout)
+{
+	int N = (int) (sizeof(timeout_steps) / sizeof(double));
+	for (int i = 0; i < N; i++) if (timeout_steps[i] >= 0.999 * timeout) return i;  // round up
+	return N - 1;
+}
+
+void set_timeout (int id, int pad, double timeout)
+{
+	struct GpibHealth *health = &gpib_board[id].health[pad];
+
+	int tmo = timeout_index(timeout);
+	if (tmo == health->tmo) return;
+	health->tmo = tmo;
+
+#if LINUXGPIB || NI488
+	if (gpib_board[id].is_real && gpib_board[id].dev[pad] >= 0) ibtmo(gpib_board[id].dev[pad], tmo + 1);
+#endif
 }
 
 void gpib_device_set_eos (int id, int pad, int eos)
@@ -18,40 +18,156 @@
 #ifndef _LIB_HARDWARE_GPIB_H
 #define _LIB_HARDWARE_GPIB_H 1
 
+#include <stdbool.h>
+
+typedef struct
+{
+	int N_slot;                     // slots being polled
+	int N_suspended;                // slots no expression reads anymore, see below
+	double utilization;             // fraction of the last M2_GPIB_STATS_WINDOW spent on bus transactions
+	double load;                    // requested: sum over slots of (time per query) / period, > 1 when oversubscribed
+	long N_query, N_timeout, N_write;
+	int N_down;                     // devices not responding, see below
+
+} GpibBoardStats;
+
+typedef struct
+{
+	int pad;
+	char cmd [16];                  // truncated
+	double send_time;               // seconds writing the query (moving average)
+	double reply_time;              // seconds the bus waited for and read the reply, i.e., whatever device latency was not overlapped with other devices, plus read (moving average)
+	double rate, rate_target;       // Hz, achieved and requested
+	long N_query, N_timeout, N_late;
+	long N_write, N_write_merged;   // setpoints sent, and superseded before they could be
+	bool responding;
+	int refs;                       // expressions reading the slot, 0 when suspended
+	double timeout;                 // seconds, current polling timeout
+
+} GpibSlotStats;
+
 // configuration
 
 void gpib_init  (void);
 void gpib_final (void);
 
-int    gpib_board_connect (int id, const char *node);
-char * gpib_board_info    (int id, const char *info);  // returns internal string (do not free)
-void   gpib_board_reset   (int id);
+int    gpib_board_connect   (int id, const char *node);
+int    gpib_board_connected (int id);
+char * gpib_board_info      (int id, const char *info);  // returns internal string (do not free)
+int    gpib_board_stats     (int id, GpibBoardStats *stats);
+void   gpib_board_reset     (int id);
 
 void gpib_device_set_eos (int id, int pad, int eos);
 
+char * gpib_device_idn      (int id, int pad, const char *cmd);  // see below, returns new string (free it) or NULL
+int    gpib_device_identify (void);
+void   gpib_device_forget   (int id, int pad);                   // pad -1 means every device on the board
+
 // basic operation
 
 char * gpib_string_query (int id, int pad, char *cmd, int cmdlen, int expect_reply);
 
 // asynchronous operation
 
-int gpib_slot_add   (int id, int pad, const char *cmd, double dt, double dummy_value, const char *reply_fmt, const char *write_fmt, void *py_noninv_f, void *py_inv_f);
-int gpib_slot_read  (int id, int s, double *x);
-int gpib_slot_write (int id, int s, double target);
+int gpib_slot_add      (int id, int pad, const char *cmd, double dt, int priority, double dummy_value, const char *reply_fmt, const char *write_fmt, void *py_noninv_f, void *py_inv_f);
+int gpib_slot_coalesce (int id, int s, const char *prefix, const char *item, const char *sep);
+int gpib_slot_convert  (int id, int s, const char *parser, double scale, double offset);  // see below
+int gpib_slot_throttle (int id, int s, double write_dt);  // minimum s between setpoint writes (default M2_GPIB_WRITE_INTERVAL)
+int gpib_slot_read     (int id, int s, double *x);
+int gpib_slot_age      (int id, int s, double *age, long *seq);  // s since the value was measured, and a count of measurements
+int gpib_slot_write    (int id, int s, double target);
+int gpib_slot_stats    (int id, int s, GpibSlotStats *stats);
+int gpib_slot_hold     (int id, int s, const void *owner);  // see below
+
+void gpib_slot_release (const void *owner);  // drops owner's holds on every board
 
-int  gpib_multi_tick     (int id);
-void gpib_multi_transfer (int id);
+int  gpib_multi_tick      (int id);
+void gpib_multi_interrupt (int id);  // makes a running gpib_multi_tick() return after its current round
+void gpib_multi_transfer  (int id);
+void gpib_multi_flush     (int id);  // sends any held-back setpoints, waiting out their rate limits
 
 // Notes on thread safety:
 //
-//   1) gpib_slot_read() and gpib_slot_write(), and gpib_multi_transfer() should
-//      be called one at a time. This is accomplished externally through
-//      ThreadVars.gpib_mutex.
+//   1) Each board's slot table has its own lock, taken by gpib_slot_add(),
+//      gpib_slot_coalesce(), gpib_slot_convert(), gpib_slot_throttle(),
+//      gpib_slot_read(), gpib_slot_age(), gpib_slot_write(), gpib_slot_stats(),
+//      gpib_slot_hold(), gpib_slot_release(), gpib_board_stats(),
+//      gpib_device_idn(), gpib_device_forget(), gpib_multi_interrupt(),
+//      gpib_multi_transfer(), and gpib_board_reset(), so these may be called
+//      from any thread. Different boards never contend. Statistics are as of
+//      the last gpib_multi_transfer().
+//
+//   2) gpib_multi_tick(), gpib_multi_flush(), gpib_string_query(), and
+//      gpib_device_identify() do the actual bus I/O and should be called one
+//      at a time per board, i.e., from that board's worker thread, or (for
+//      gpib_device_identify()) while no workers are running.
+//      gpib_multi_tick() takes the lock only to snapshot the slot table, never
+//      while talking to an instrument.
+
+// Notes on gpib_slot_convert():
+//
+//   The parser replaces the slot's sscanf() reply format:
+//
+//      ""              keep using reply_fmt
+//      "field:A:W"     the W characters starting at character A
+//      "split:N:SEP"   the Nth (from 0) piece of the reply, split on SEP
+//      "number:N"      the Nth (from 0) number anywhere in the reply
+//
+//   With scale != 0, gpib_slot_read() returns scale * raw + offset and
+//   gpib_slot_write() sends (target - offset) / scale, without calling the
+//   slot's Python functions.
+
+// Notes on gpib_device_idn():
+//
+//   Identification replies (e.g. to "*IDN?") are cached per address. A miss
+//   returns NULL and queues the query, and gpib_device_identify() then asks
+//   every queued device at once: one thread per board, with each board's
+//   queries all sent before any reply is read. Entries stay valid across
+//   gpib_board_reset(), and are forgotten by gpib_device_forget(),
+//   gpib_board_connect(), or when a device stops responding. A device that
+//   does not answer is asked again the next time.
+
+// Notes on gpib_slot_hold():
+//
+//   Slots are only polled while something holds them. An owner (in practice,
+//   the ComputeFunc of a channel or trigger line) holds each slot it reads, and
+//   lets go of all of them with gpib_slot_release() before it is re-parsed, so
+//   slots left behind by an edited expression stop taking bus time. Such a slot
+//   is suspended rather than removed, since its index may still be cached, and
+//   comes back into the polling set (due right away) with its next holder.
+//   Pending setpoints are still sent. gpib_board_reset() drops every slot and
+//   every hold at once.
+
+// Notes on scheduling:
+//
+//   gpib_multi_tick() services pending writes first, then queries each slot
+//   whose deadline has passed, earliest deadline first among the highest
+//   priority. Queries to different devices are sent back to back before any
+//   reply is read, so slow instruments measure concurrently; slots sharing a
+//   device go out in successive rounds. Each slot's query time is measured;
+//   when the sum of cost/period exceeds one the board is oversubscribed, a
+//   warning is posted, and slots that fall a full period behind are
+//   rescheduled rather than queued up.
+//
+//   Slots given a compound query by gpib_slot_coalesce() share a round trip:
+//   those on one device with the same prefix and separator that are due, or
+//   within half a period of it, are read as prefix+item1+sep+item2+... and
+//   the reply is split on sep (e.g. "SNAP?" + "1,2,3" on an SR830, or ""
+//   + "MEAS:VOLT?;MEAS:CURR?" on a SCPI meter).
+//
+//   Setpoints from gpib_slot_write() are sent at most once per write_dt per
+//   slot. A setpoint that arrives sooner is held back and replaced by any
+//   newer one, so a sweep sends only the latest value, and the last value of
+//   the sweep always goes out. The slot is not queried while a setpoint is
+//   held back. An eligible write interrupts a running gpib_multi_tick().
 //
-//   2) gpib_slot_add(), gpib_multi_tick(), and gpib_string_query() should be
-//      called one at a time. This is accomplished by parsing the channels during
-//      the panel startup phase, when only the GUI thread is running. Channels
-//      which contain conditionals may generate calls to gpib_slot_add() during
-//      regular operation, which could be bad . . .
+//   Each device's polling timeout follows its observed reply latency
+//   (M2_GPIB_TIMEOUT_FACTOR times, within M2_GPIB_TIMEOUT_MIN and
+//   M2_GPIB_TIMEOUT). After a failed query the device is left alone for
+//   M2_GPIB_BACKOFF_MIN, doubling with each further failure up to
+//   M2_GPIB_BACKOFF_MAX, and the next query is a probe with the full
+//   timeout. After M2_GPIB_DOWN_FAILS failures in a row the device is
+//   reported as not responding, and its slots no longer count toward the
+//   board's load. The first answer brings it back to its normal rate.
 
 #endif
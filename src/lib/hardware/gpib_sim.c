@@ -0,0 +1,342 @@
+/*
+ *  Copyright (C) 2012 California Institute of Technology
+ *
+ *  This file is part of Mezurit2, written by Brian Standley <brian@brianstandley.com>.
+ *
+ *  Mezurit2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Foundation,
+ *  either version 3 of the License, or (at your option) any later version.
+ *
+ *  Mezurit2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE. See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with this
+ *  program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Built-in instrument models, answering on any address, for the GPIB_Device definitions in compute.py.
+// Script syntax, one rule per line, first match wins:
+//
+//   <pad|*>  <command>  <latency ms>  <jitter ms>  <generator>  [<reply format>]
+//
+// The command is matched against the start of each message. Generators:
+//
+//   const:V                   reply V
+//   gauss:MEAN:SD             reply MEAN plus gaussian noise
+//   ramp:V0:RATE              reply V0 + RATE*t (t in s since connecting)
+//   sine:MEAN:AMP:PERIOD      reply MEAN + AMP*sin(2πt/PERIOD)
+//   reg:NAME[:INIT]           reply register NAME (per device)
+//   set:NAME                  store the number following the command in register NAME, no reply
+//   map:PREFIX                answer each comma-separated item following the command as PREFIX+item,
+//                             formatted with this rule's reply format and joined by commas
+//   text                      reply the reply format verbatim
+//   timeout                   never reply
+//
+// Reply formats take \r, \n, \t, \s (space) and \\ escapes and default to "%g\n". Messages which
+// match no rule are accepted silently, and queries are left to time out.
+
+static const char sim_default_script[] =
+	"*  *IDN?      2   0.5  text              Mezurit2,Simulated\\sinstrument,0,1.0\\n\n"
+	"*  V\\r        20  5    text              Simulated\\sOxford\\sinstrument\\r\n"
+	"*  FREQ:CW?   15  3    reg:FREQ:1e6      %1.8e\\n\n"
+	"*  FREQ:CW\\s  10  2    set:FREQ\n"
+	"*  POW:AMPL?  15  3    reg:AMPL:-10      %1.6f\\n\n"
+	"*  POW:AMPL\\s 10  2    set:AMPL\n"
+	"*  SLVL?      8   2    reg:SLVL:50e-3\n"
+	"*  SLVL       5   1    set:SLVL\n"
+	"*  SENS?      8   2    reg:SENS:17\n"
+	"*  SENS       5   1    set:SENS\n"
+	"*  OUTP?1     10  2    sine:1e-3:1e-4:10\n"
+	"*  OUTP?2     10  2    gauss:0:1e-5\n"
+	"*  OUTP?3     10  2    sine:1e-3:1e-4:10\n"
+	"*  OUTP?4     10  2    gauss:45:0.5\n"
+	"*  SNAP?      12  2    map:OUTP?         %g\n"
+	"*  R1\\r       60  15   ramp:300:-0.01    R%0.3f\\r\n"
+	"*  R8\\r       60  15   sine:0:1:600      R%0.4f\\r\n";
+
+bool sim_parse (struct SimBus *sim, const char *node)
+{
+	// node syntax:  "sim" or "sim:key=value,key=value,..."
+	// keys:         script (rules file, relative to the config dir unless absolute), defaults (0: skip built-in rules), seed
+
+	sim_clear(sim);
+
+	char *script _strfree_ = NULL;
+	bool defaults = 1;
+	uint32_t seed = 1;
+
+	const char *p = &node[3];  // skip "sim"
+	if      (*p == ':')  p++;
+	else if (*p != '\0') return 0;
+
+	while (*p != '\0')
+	{
+		char key[16], value[256];
+		int n = 0;
+		if (sscanf(p, "%15[^=]=%255[^,]%n", key, value, &n) != 2) return 0;
+		p += n;
+
+		if      (str_equal(key, "script"))   { replace(script, (value[0] == '/') ? cat1(value) : configpath(value)); }
+		else if (str_equal(key, "defaults")) defaults = (atoi(value) != 0);
+		else if (str_equal(key, "seed"))     seed = (uint32_t) atol(value);
+		else return 0;
+
+		if      (*p == ',')  p++;
+		else if (*p != '\0') return 0;
+	}
+
+	sim->rng = (seed != 0) ? seed : 1;  // xorshift state must be nonzero
+
+	if (script != NULL)
+	{
+		FILE *file = fopen(script, "r");
+		if (file == NULL)
+		{
+			status_add(0, supercat("GPIB Error: Unable to open simulator script %s.\n", script));
+			return 0;
+		}
+
+		char line[M2_GPIB_BUF_LENGTH + 1];
+		int n_line = 0;
+		bool ok = 1;
+		while (ok && fgets(line, sizeof(line), file) != NULL)
+		{
+			n_line++;
+			ok = sim_add_rule(sim, line);
+			if (!ok) status_add(0, supercat("GPIB Error: Unable to parse line %d of simulator script %s.\n", n_line, script));
+		}
+		fclose(file);
+
+		if (!ok) return 0;
+	}
+
+	if (defaults)
+	{
+		char *text _strfree_ = cat1(sim_default_script);
+		for (char *line = strtok(text, "\n"); line != NULL; line = strtok(NULL, "\n"))
+			f_verify(sim_add_rule(sim, line), NULL, return 0);
+	}
+
+	return 1;
+}
+
+bool sim_add_rule (struct SimBus *sim, const char *line)
+{
+	char pad_str[8], cmd[64], gen[64], reply_fmt[128];
+	double latency, jitter;
+
+	int n = sscanf(line, "%7s %63s %lf %lf %63s %127s", pad_str, cmd, &latency, &jitter, gen, reply_fmt);
+	if (n <= 0 || pad_str[0] == '#') return 1;  // blank or comment
+	if (n < 5) return 0;
+
+	struct SimRule *rule = malloc(sizeof(struct SimRule));
+
+	rule->pad = str_equal(pad_str, "*") ? -1 : atoi(pad_str);
+	rule->cmd = sim_unescape(cmd);
+	rule->cmdlen = str_length(rule->cmd);
+	rule->latency = latency * 1e-3;
+	rule->jitter = jitter * 1e-3;
+	rule->reply_fmt = sim_unescape(n == 6 ? reply_fmt : "%g\\n");
+	rule->name = NULL;
+	rule->p[0] = rule->p[1] = rule->p[2] = 0.0;
+
+	char name[64] = "";
+	bool ok = 1;
+	if      (strncmp(gen, "const:", 6) == 0) { rule->gen = SIM_CONST; ok = (sscanf(gen, "const:%lf",              &rule->p[0])                         == 1); }
+	else if (strncmp(gen, "gauss:", 6) == 0) { rule->gen = SIM_GAUSS; ok = (sscanf(gen, "gauss:%lf:%lf",          &rule->p[0], &rule->p[1])            == 2); }
+	else if (strncmp(gen, "ramp:",  5) == 0) { rule->gen = SIM_RAMP;  ok = (sscanf(gen, "ramp:%lf:%lf",           &rule->p[0], &rule->p[1])            == 2); }
+	else if (strncmp(gen, "sine:",  5) == 0) { rule->gen = SIM_SINE;  ok = (sscanf(gen, "sine:%lf:%lf:%lf",       &rule->p[0], &rule->p[1], &rule->p[2]) == 3 && rule->p[2] > 0); }
+	else if (strncmp(gen, "reg:",   4) == 0) { rule->gen = SIM_REG;   ok = (sscanf(gen, "reg:%63[^:]:%lf", name, &rule->p[0]) >= 1); }
+	else if (strncmp(gen, "set:",   4) == 0) { rule->gen = SIM_SET;   ok = (sscanf(gen, "set:%63s",         name)              == 1); }
+	else if (strncmp(gen, "map:",   4) == 0) { rule->gen = SIM_MAP;   ok = (sscanf(gen, "map:%63s",         name)              == 1); }
+	else if (str_equal(gen, "text"))         { rule->gen = SIM_TEXT;    }
+	else if (str_equal(gen, "timeout"))      { rule->gen = SIM_TIMEOUT; }
+	else ok = 0;
+
+	if (rule->gen == SIM_MAP) rule->name = sim_unescape(name);
+	else if (name[0] != '\0') rule->name = cat1(name);
+
+	if (!ok || rule->pad < -1 || rule->pad >= M2_GPIB_MAX_PAD || rule->cmdlen == 0 || rule->latency < 0 || rule->jitter < 0)
+	{
+		free_sim_rule_cb(rule);
+		free(rule);
+		return 0;
+	}
+
+	pile_add(&sim->rules, rule);
+	return 1;
+}
+
+char * sim_unescape (const char *str)
+{
+	char *out = cat1(str);
+
+	char *q = out;
+	for (const char *p = str; *p != '\0'; p++)
+	{
+		if (*p == '\\' && p[1] != '\0')
+		{
+			p++;
+			switch (*p)
+			{
+				case 'r' : *q++ = '\r'; break;
+				case 'n' : *q++ = '\n'; break;
+				case 't' : *q++ = '\t'; break;
+				case 's' : *q++ = ' ';  break;
+				default  : *q++ = *p;
+			}
+		}
+		else *q++ = *p;
+	}
+	*q = '\0';
+
+	return out;
+}
+
+void sim_clear (struct SimBus *sim)
+{
+	pile_gc(&sim->rules, PILE_CALLBACK(free_sim_rule_cb));
+	pile_gc(&sim->regs,  PILE_CALLBACK(free_sim_reg_cb));
+
+	for (int pad = 0; pad < M2_GPIB_MAX_PAD; pad++) replace(sim->query[pad], NULL);
+}
+
+void free_sim_rule_cb (struct SimRule *rule)
+{
+	free(rule->cmd);
+	free(rule->name);
+	free(rule->reply_fmt);
+}
+
+void free_sim_reg_cb (struct SimRegister *reg)
+{
+	free(reg->name);
+}
+
+struct SimRule * sim_match (struct SimBus *sim, int pad, const char *msg)
+{
+	struct SimRule *rule = pile_first(&sim->rules);
+	while (rule != NULL)
+	{
+		if ((rule->pad == -1 || rule->pad == pad) && strncmp(msg, rule->cmd, (size_t) rule->cmdlen) == 0) return rule;
+		rule = pile_inc(&sim->rules);
+	}
+
+	return NULL;
+}
+
+double * sim_register (struct SimBus *sim, int pad, const char *name, double init)
+{
+	struct SimRegister *reg = pile_first(&sim->regs);
+	while (reg != NULL)
+	{
+		if (reg->pad == pad && str_equal(reg->name, name)) return &reg->value;
+		reg = pile_inc(&sim->regs);
+	}
+
+	reg = malloc(sizeof(struct SimRegister));
+	reg->pad = pad;
+	reg->name = cat1(name);
+	reg->value = init;
+	pile_add(&sim->regs, reg);
+
+	return &reg->value;
+}
+
+double sim_gauss (struct SimBus *sim)
+{
+	// xorshift32 plus Box-Muller, so runs are reproducible for a given seed
+
+	double u[2];
+	for (int i = 0; i < 2; i++)
+	{
+		sim->rng ^= sim->rng << 13;
+		sim->rng ^= sim->rng >> 17;
+		sim->rng ^= sim->rng << 5;
+		u[i] = ((double) sim->rng + 1.0) / 4294967296.0;  // (0, 1]
+	}
+
+	return sqrt(-2.0 * log(u[0])) * cos(2*U_PI * u[1]);
+}
+
+double sim_value (struct SimBus *sim, struct SimRule *rule, int pad, double t)
+{
+	switch (rule->gen)
+	{
+		case SIM_CONST : return rule->p[0];
+		case SIM_GAUSS : return rule->p[0] + rule->p[1] * sim_gauss(sim);
+		case SIM_RAMP  : return rule->p[0] + rule->p[1] * t;
+		case SIM_SINE  : return rule->p[0] + rule->p[1] * sin(2*U_PI * t / rule->p[2]);
+		case SIM_REG   : return *sim_register(sim, pad, rule->name, rule->p[0]);
+		default        : return 0.0;
+	}
+}
+
+void sim_send (struct GpibBoard *board, int pad, const char *cmd, int cmdlen)
+{
+	struct SimBus *sim = &board->sim;
+	xleep(M2_GPIB_SIM_OVERHEAD);
+
+	char *msg _strfree_ = malloc((size_t) cmdlen + 1);
+	memcpy(msg, cmd, (size_t) cmdlen);
+	msg[cmdlen] = '\0';
+
+	mt_mutex_lock(&board->lock);  // registers and the generator state are shared with gpib_string_query() callers
+	struct SimRule *rule = sim_match(sim, pad, msg);
+	if (rule != NULL && rule->gen == SIM_SET) sscanf(&msg[rule->cmdlen], "%lf", sim_register(sim, pad, rule->name, 0.0));
+	mt_mutex_unlock(&board->lock);
+
+	replace(sim->query[pad], cat1(msg));
+	sim->t_query[pad] = timer_elapsed(board->clock);
+}
+
+long sim_receive (struct GpibBoard *board, int pad)
+{
+	struct SimBus *sim = &board->sim;
+
+	char *msg _strfree_ = sim->query[pad];
+	sim->query[pad] = NULL;
+
+	mt_mutex_lock(&board->lock);
+	struct SimRule *rule = (msg != NULL) ? sim_match(sim, pad, msg) : NULL;
+	double t = timer_elapsed(board->clock);
+	double t_ready = (rule != NULL) ? sim->t_query[pad] + max_double(rule->latency + rule->jitter * sim_gauss(sim), 0.0) : 0.0;
+	double timeout = timeout_steps[board->health[pad].tmo];
+
+	if (rule == NULL || rule->gen == SIM_SET || rule->gen == SIM_TIMEOUT || t_ready - t > timeout)  // like a real device, a reply that is too slow is lost
+	{
+		mt_mutex_unlock(&board->lock);
+		xleep(timeout);
+		return -1;
+	}
+
+	char *buf = board->buf;
+
+	if (rule->gen == SIM_TEXT) snprintf(buf, M2_GPIB_BUF_LENGTH, "%s", rule->reply_fmt);
+	else if (rule->gen == SIM_MAP)
+	{
+		buf[0] = '\0';
+		for (const char *item = &msg[rule->cmdlen]; *item != '\0'; )
+		{
+			size_t n = strcspn(item, ",");
+			char *sub_msg _strfree_ = supercat("%s%.*s", rule->name, (int) n, item);
+			item += (item[n] == ',') ? n + 1 : n;
+
+			struct SimRule *sub = sim_match(sim, pad, sub_msg);
+			char *value _strfree_ = supercat(rule->reply_fmt, (sub != NULL) ? sim_value(sim, sub, pad, t) : 0.0);
+
+			int len = str_length(buf);
+			snprintf(buf + len, (size_t) (M2_GPIB_BUF_LENGTH - len), (len > 0) ? ",%s" : "%s", value);
+		}
+		int len = str_length(buf);
+		snprintf(buf + len, (size_t) (M2_GPIB_BUF_LENGTH - len), "\n");
+	}
+	else snprintf(buf, M2_GPIB_BUF_LENGTH, rule->reply_fmt, sim_value(sim, rule, pad, t));
+	mt_mutex_unlock(&board->lock);
+
+	if (t_ready > t) xleep(t_ready - t);  // the instrument is still measuring
+	xleep(M2_GPIB_SIM_OVERHEAD);
+
+	return str_length(buf);
+}
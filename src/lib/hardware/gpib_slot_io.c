@@ -21,9 +21,14 @@ void free_slot_cb (struct GpibSlot *slot)
 	free(slot->reply_fmt);
 	free(slot->write_fmt);
 	free(slot->dummy_buf);
+	free(slot->group_prefix);
+	free(slot->group_item);
+	free(slot->group_sep);
+	free(slot->parse_sep);
+	free(slot->owner);
 }
 
-int gpib_slot_add (int id, int pad, const char *cmd, double dt, double dummy_value, const char *reply_fmt, const char *write_fmt, void *py_noninv_f, void *py_inv_f)
+int gpib_slot_add (int id, int pad, const char *cmd, double dt, int priority, double dummy_value, const char *reply_fmt, const char *write_fmt, void *py_noninv_f, void *py_inv_f)
 {
 	f_verify(id >= 0 && id < M2_GPIB_MAX_BRD,   GPIB_ID_WARNING_MSG,  return -1);
 	f_verify(gpib_board[id].is_connected,       NULL,                 return -1);
@@ -41,22 +46,142 @@ int gpib_slot_add (int id, int pad, const char *cmd, double dt, double dummy_val
 	slot->py_inv_f = py_inv_f;
 	slot->cmdlen = str_length(cmd);
 
-	if (gpib_board[id].is_real) slot->dummy_buf = NULL;
+	if (gpib_board[id].is_real || gpib_board[id].is_sim) slot->dummy_buf = NULL;
 	else
 	{
 		slot->dummy_buf = new_str(M2_GPIB_BUF_LENGTH);
 		snprintf(slot->dummy_buf, M2_GPIB_BUF_LENGTH, reply_fmt, dummy_value);
 	}
 
-	slot->timer = timer_new();
 	slot->dt = dt;
+	slot->priority = priority;
+	slot->due = 0.0;  // poll right away
+	slot->cost = -1.0;
+	slot->N_late = 0;
+
+	slot->write_dt = M2_GPIB_WRITE_INTERVAL;
+	slot->write_next = slot->write_next_global = 0.0;
+	slot->N_write = slot->N_write_merged = 0;
+
+	memset(&slot->stats, 0, sizeof(GpibSlotStats));
+	slot->stats.pad = pad;
+	snprintf(slot->stats.cmd, sizeof(slot->stats.cmd), "%s", cmd);
+	slot->stats.send_time = slot->stats.reply_time = -1.0;  // unknown
+	slot->stats.responding = 1;
+	slot->stats.timeout = M2_GPIB_TIMEOUT;
+	slot->stats.rate_target = (dt > 0.0) ? 1.0 / dt : 0.0;
+	slot->stats_global = slot->stats;
+	slot->seq_window = 0;
+
+	slot->owner = NULL;
+	slot->N_owner = slot->owner_size = 0;
+
+	slot->group_prefix = slot->group_item = slot->group_sep = NULL;
+	slot->group_next = NULL;
+
+	slot->parse_mode = GPIB_PARSE_FORMAT;
+	slot->parse_a = slot->parse_b = 0;
+	slot->parse_sep = NULL;
+	slot->affine = 0;
+	slot->scale = 1.0;
+	slot->offset = 0.0;
 
 	slot->write_request_local = slot->write_request_global = 0;
 	slot->known_local         = slot->known_global         = 0;
 	slot->current_local       = slot->current_global       = 0.0;
+	slot->t_local             = slot->t_global             = 0.0;
+	slot->seq_local           = slot->seq_global           = 0;
 	
+	mt_mutex_lock(&gpib_board[id].lock);
 	pile_add(&gpib_board[id].slots, slot);
-	return (int) gpib_board[id].slots.occupied - 1;  // slot id
+	int s = (int) gpib_board[id].slots.occupied - 1;  // slot id
+	mt_mutex_unlock(&gpib_board[id].lock);
+
+	return s;
+}
+
+int gpib_slot_coalesce (int id, int s, const char *prefix, const char *item, const char *sep)
+{
+	f_verify(id >= 0 && id < M2_GPIB_MAX_BRD, GPIB_ID_WARNING_MSG, return 0);
+	f_verify(gpib_board[id].is_connected,     NULL,                return 0);
+	f_verify(str_length(item) > 0 && str_length(sep) > 0, "Warning: Incomplete GPIB query coalescing description.\n", return 0);
+
+	mt_mutex_lock(&gpib_board[id].lock);
+	struct GpibSlot *slot = pile_item(&gpib_board[id].slots, (size_t) s);
+	mt_mutex_unlock(&gpib_board[id].lock);
+
+	if (slot == NULL)
+	{
+		f_print(F_ERROR, "Error: Slot index out of range.\n");
+		return 0;
+	}
+	else
+	{
+		// only ever called right after gpib_slot_add(), before the worker sees the description
+		replace(slot->group_prefix, cat1(prefix));
+		replace(slot->group_item,   cat1(item));
+		replace(slot->group_sep,    cat1(sep));
+
+		return 1;
+	}
+}
+
+int gpib_slot_convert (int id, int s, const char *parser, double scale, double offset)
+{
+	f_verify(id >= 0 && id < M2_GPIB_MAX_BRD, GPIB_ID_WARNING_MSG, return 0);
+	f_verify(gpib_board[id].is_connected,     NULL,                return 0);
+
+	mt_mutex_lock(&gpib_board[id].lock);
+	struct GpibSlot *slot = pile_item(&gpib_board[id].slots, (size_t) s);
+	mt_mutex_unlock(&gpib_board[id].lock);
+
+	if (slot == NULL)
+	{
+		f_print(F_ERROR, "Error: Slot index out of range.\n");
+		return 0;
+	}
+
+	// compile the parser description once, here, rather than on every reply:
+	int mode, a = 0, b = 0, n = 0;
+	if (str_length(parser) == 0) mode = GPIB_PARSE_FORMAT;
+	else if (sscanf(parser, "field:%d:%d%n", &a, &b, &n) == 2 && parser[n] == '\0' && a >= 0 && b > 0) mode = GPIB_PARSE_FIELD;
+	else if (sscanf(parser, "split:%d:%n", &a, &n) == 1 && n > 0 && parser[n] != '\0' && a >= 0) mode = GPIB_PARSE_SPLIT;
+	else if (sscanf(parser, "number:%d%n", &a, &n) == 1 && parser[n] == '\0' && a >= 0) mode = GPIB_PARSE_NUMBER;
+	else
+	{
+		f_print(F_WARNING, "Warning: Unknown GPIB reply parser \"%s\".\n", parser);
+		return 0;
+	}
+
+	// only ever called right after gpib_slot_add(), before the worker sees the description
+	slot->parse_mode = mode;
+	slot->parse_a = a;
+	slot->parse_b = b;
+	replace(slot->parse_sep, (mode == GPIB_PARSE_SPLIT) ? cat1(parser + n) : NULL);
+
+	slot->affine = (scale != 0.0);
+	slot->scale = slot->affine ? scale : 1.0;
+	slot->offset = slot->affine ? offset : 0.0;
+
+	return 1;
+}
+
+int gpib_slot_throttle (int id, int s, double write_dt)
+{
+	f_verify(id >= 0 && id < M2_GPIB_MAX_BRD, GPIB_ID_WARNING_MSG, return 0);
+	f_verify(gpib_board[id].is_connected,     NULL,                return 0);
+
+	mt_mutex_lock(&gpib_board[id].lock);
+	struct GpibSlot *slot = pile_item(&gpib_board[id].slots, (size_t) s);
+	if (slot != NULL) slot->write_dt = max_double(write_dt, 0.0);
+	mt_mutex_unlock(&gpib_board[id].lock);
+
+	if (slot == NULL)
+	{
+		f_print(F_ERROR, "Error: Slot index out of range.\n");
+		return 0;
+	}
+	else return 1;
 }
 
 int gpib_slot_read (int id, int s, double *x)
@@ -64,18 +189,24 @@ int gpib_slot_read (int id, int s, double *x)
 	f_verify(id >= 0 && id < M2_GPIB_MAX_BRD, NULL, return 0);
 	f_verify(gpib_board[id].is_connected,     NULL, return 0);
 
+	mt_mutex_lock(&gpib_board[id].lock);
 	struct GpibSlot *slot = pile_item(&gpib_board[id].slots, (size_t) s);
+	bool known = (slot != NULL && slot->known_global);
+	double current = known ? slot->current_global : 0.0;
+	mt_mutex_unlock(&gpib_board[id].lock);
+
 	if (slot == NULL)
 	{
 		f_print(F_ERROR, "Error: Slot index out of range.\n");
 		return 0;
 	}
-	else if (slot->known_global)
+	else if (known)
 	{
-		if (slot->py_noninv_f == NULL) *x = slot->current_global;  // straight through
+		if      (slot->affine)              *x = slot->scale * current + slot->offset;
+		else if (slot->py_noninv_f == NULL) *x = current;  // straight through
 		else
 		{
-			PyObject *py_x  _pyfree_ = PyFloat_FromDouble(slot->current_global);
+			PyObject *py_x  _pyfree_ = PyFloat_FromDouble(current);
 			PyObject *py_rv _pyfree_ = PyObject_CallFunctionObjArgs(slot->py_noninv_f, py_x, NULL);
 			
 			if (py_rv != NULL) *x = PyFloat_AsDouble(py_rv);
@@ -87,12 +218,100 @@ int gpib_slot_read (int id, int s, double *x)
 	else return 0;
 }
 
+int gpib_slot_age (int id, int s, double *age, long *seq)
+{
+	f_verify(id >= 0 && id < M2_GPIB_MAX_BRD, NULL, return 0);
+	f_verify(gpib_board[id].is_connected,     NULL, return 0);
+
+	mt_mutex_lock(&gpib_board[id].lock);
+	struct GpibSlot *slot = pile_item(&gpib_board[id].slots, (size_t) s);
+	bool measured = (slot != NULL && slot->seq_global > 0);
+	if (measured)
+	{
+		*age = timer_elapsed(gpib_board[id].clock) - slot->t_global;
+		*seq = slot->seq_global;
+	}
+	mt_mutex_unlock(&gpib_board[id].lock);
+
+	return measured ? 1 : 0;
+}
+
+int gpib_slot_stats (int id, int s, GpibSlotStats *stats)
+{
+	f_verify(id >= 0 && id < M2_GPIB_MAX_BRD, GPIB_ID_WARNING_MSG, return 0);
+	f_verify(gpib_board[id].is_connected,     NULL,                return 0);
+
+	mt_mutex_lock(&gpib_board[id].lock);
+	struct GpibSlot *slot = pile_item(&gpib_board[id].slots, (size_t) s);
+	if (slot != NULL) *stats = slot->stats_global;
+	mt_mutex_unlock(&gpib_board[id].lock);
+
+	return (slot != NULL) ? 1 : 0;
+}
+
+int gpib_slot_hold (int id, int s, const void *owner)
+{
+	f_verify(id >= 0 && id < M2_GPIB_MAX_BRD, NULL, return 0);
+	f_verify(gpib_board[id].is_connected,     NULL, return 0);
+
+	mt_mutex_lock(&gpib_board[id].lock);
+	struct GpibSlot *slot = pile_item(&gpib_board[id].slots, (size_t) s);
+	if (slot != NULL)
+	{
+		bool held = 0;
+		for (int i = 0; i < slot->N_owner && !held; i++) held = (slot->owner[i] == owner);
+
+		if (!held)
+		{
+			if (slot->N_owner == slot->owner_size)
+			{
+				slot->owner_size = (slot->owner_size > 0) ? 2 * slot->owner_size : 4;
+				slot->owner = realloc(slot->owner, (size_t) slot->owner_size * sizeof(const void *));
+			}
+			slot->owner[slot->N_owner++] = owner;
+		}
+	}
+	mt_mutex_unlock(&gpib_board[id].lock);
+
+	return (slot != NULL) ? 1 : 0;
+}
+
+void gpib_slot_release (const void *owner)
+{
+	for (int id = 0; id < M2_GPIB_MAX_BRD; id++) if (gpib_board[id].is_connected)
+	{
+		mt_mutex_lock(&gpib_board[id].lock);
+		for (struct GpibSlot *slot = pile_first(&gpib_board[id].slots); slot != NULL; slot = pile_inc(&gpib_board[id].slots))
+			for (int i = 0; i < slot->N_owner; i++) if (slot->owner[i] == owner)
+			{
+				slot->owner[i] = slot->owner[--slot->N_owner];  // order does not matter
+				break;
+			}
+		mt_mutex_unlock(&gpib_board[id].lock);
+	}
+}
+
+int gpib_board_stats (int id, GpibBoardStats *stats)
+{
+	f_verify(id >= 0 && id < M2_GPIB_MAX_BRD, GPIB_ID_WARNING_MSG, return 0);
+	f_verify(gpib_board[id].is_connected,     NULL,                return 0);
+
+	mt_mutex_lock(&gpib_board[id].lock);
+	*stats = gpib_board[id].stats_global;
+	mt_mutex_unlock(&gpib_board[id].lock);
+
+	return 1;
+}
+
 int gpib_slot_write (int id, int s, double target)
 {
 	f_verify(id >= 0 && id < M2_GPIB_MAX_BRD, GPIB_ID_WARNING_MSG, return 0);
 	f_verify(gpib_board[id].is_connected,     NULL,                return 0);
 
+	mt_mutex_lock(&gpib_board[id].lock);
 	struct GpibSlot *slot = pile_item(&gpib_board[id].slots, (size_t) s);
+	mt_mutex_unlock(&gpib_board[id].lock);
+
 	if (slot == NULL)
 	{
 		f_print(F_ERROR, "Error: Slot index out of range.\n");
@@ -100,62 +319,406 @@ int gpib_slot_write (int id, int s, double target)
 	}
 	else
 	{
-		if (slot->py_inv_f == NULL) slot->current_global = target;  // straight through
-		else
+		double value = target;  // straight through
+		if (slot->affine) value = (target - slot->offset) / slot->scale;
+		else if (slot->py_inv_f != NULL)
 		{
 			PyObject *py_x  _pyfree_ = PyFloat_FromDouble(target);
 			PyObject *py_rv _pyfree_ = PyObject_CallFunctionObjArgs(slot->py_inv_f, py_x, NULL);
 
-			if (py_rv != NULL) slot->current_global = PyFloat_AsDouble(py_rv);
+			if (py_rv != NULL) value = PyFloat_AsDouble(py_rv);
 			else return 0;
 		}
 
+		mt_mutex_lock(&gpib_board[id].lock);
+		slot->current_global = value;
 		slot->known_global = 1;
 		slot->write_request_global = 1;
+		if (timer_elapsed(gpib_board[id].clock) >= slot->write_next_global) gpib_board[id].interrupt = 1;  // don't wait for the polling round
+		mt_mutex_unlock(&gpib_board[id].lock);
+
 		return 1;
 	}
 }
 
+size_t coalesce (struct GpibBoard *board, struct GpibSlot *leader, double now, size_t N)
+{
+	// Gathers other slots on the same device and with the same compound query that are due, or
+	// within half a period of it, behind the leader, and writes the compound query to board->cmd_buf.
+	// Returns the number of slots served by the query.
+
+	if (leader->group_prefix == NULL) return 1;
+
+	size_t N_member = 1;
+	struct GpibSlot *last = leader;
+	snprintf(board->cmd_buf, M2_GPIB_BUF_LENGTH, "%s%s", leader->group_prefix, leader->group_item);
+
+	for (size_t i = 0; i < N && N_member < M2_GPIB_MAX_COALESCE; i++)
+	{
+		struct GpibSlot *slot = board->queue[i];
+		if (slot != leader && slot->pad == leader->pad && slot->group_prefix != NULL && !slot->write_request_local &&
+		    str_equal(slot->group_prefix, leader->group_prefix) && str_equal(slot->group_sep, leader->group_sep) &&
+		    slot->due <= now + 0.5 * slot->dt)
+		{
+			int len = str_length(board->cmd_buf);
+			if (len + str_length(slot->group_sep) + str_length(slot->group_item) >= M2_GPIB_BUF_LENGTH) break;
+			snprintf(board->cmd_buf + len, (size_t) (M2_GPIB_BUF_LENGTH - len), "%s%s", slot->group_sep, slot->group_item);
+
+			last->group_next = slot;
+			last = slot;
+			N_member++;
+		}
+	}
+
+	return N_member;  // with no company the plain query is sent instead
+}
+
+size_t snapshot (struct GpibBoard *board)
+{
+	mt_mutex_lock(&board->lock);  // slot_add() may be growing the pile
+	if (board->slots.occupied > board->queue_size)
+	{
+		board->queue_size = board->slots.occupied;
+		board->queue = realloc(board->queue, board->queue_size * sizeof(struct GpibSlot *));
+		board->batch = realloc(board->batch, board->queue_size * sizeof(struct GpibSlot *));
+	}
+	size_t N = 0;
+	for (struct GpibSlot *slot = pile_first(&board->slots); slot != NULL; slot = pile_inc(&board->slots))
+	{
+		if (slot->N_owner > 0 || slot->write_request_local) board->queue[N++] = slot;
+		else slot->stats.rate = 0.0;  // suspended
+	}
+	board->stats.N_suspended = (int) (board->slots.occupied - N);
+	board->interrupt = 0;
+	mt_mutex_unlock(&board->lock);
+
+	return N;
+}
+
+void send_write (struct GpibBoard *board, int id, struct GpibSlot *slot)
+{
+	slot->write_request_local = 0;
+
+	if (slot->dummy_buf != NULL) snprintf(slot->dummy_buf, M2_GPIB_BUF_LENGTH, slot->reply_fmt, slot->current_local);
+
+	double t0 = timer_elapsed(board->clock);
+	snprintf(board->buf, M2_GPIB_BUF_LENGTH, slot->write_fmt, slot->current_local);
+	gpib_string_query(id, slot->pad, board->buf, str_length(board->buf), 0);
+
+	slot->write_next = t0 + slot->write_dt;
+	slot->due = timer_elapsed(board->clock) + slot->dt;  // value is already known
+	slot->N_write++;
+	board->stats.N_write++;
+}
+
+void stats_reset (struct GpibBoard *board)
+{
+	memset(&board->stats, 0, sizeof(GpibBoardStats));
+	board->stats_global = board->stats;
+	board->busy = 0.0;
+	board->window_t0 = timer_elapsed(board->clock);
+}
+
+double average (double mean, double x)
+{
+	return (mean < 0.0) ? x : (1.0 - M2_GPIB_COST_WEIGHT) * mean + M2_GPIB_COST_WEIGHT * x;  // negative means no samples yet
+}
+
+void health_reset (struct GpibBoard *board, int pad)
+{
+	board->health[pad].tmo = timeout_index(M2_GPIB_TIMEOUT);  // as set by ibdev()
+	board->health[pad].latency = -1.0;
+	board->health[pad].N_fail = 0;
+	board->health[pad].retry_at = 0.0;
+	board->health[pad].down = 0;
+}
+
+void health_update (int id, int pad, bool answered, double latency, double now)
+{
+	// latency runs from the end of the device's query, so within a round it also includes the sends of
+	// the devices queried after it and the reads of those answering before it. That overstates the
+	// device's own latency, which is what the polling timeout needs: it must never be cut short by a
+	// busy round.
+
+	struct GpibHealth *health = &gpib_board[id].health[pad];
+
+	if (answered)
+	{
+		if (health->down) status_add(0, supercat("GPIB device %d on board %d is responding again.\n", pad, id));
+
+		health->latency = average(health->latency, latency);
+		health->N_fail = 0;
+		health->down = 0;
+	}
+	else
+	{
+		// back off, so that a dead device costs at most one timeout per M2_GPIB_BACKOFF_MAX:
+		health->N_fail++;
+		health->retry_at = now + min_double(M2_GPIB_BACKOFF_MIN * pow(2.0, health->N_fail - 1), M2_GPIB_BACKOFF_MAX);
+
+		if (health->N_fail == M2_GPIB_DOWN_FAILS)
+		{
+			health->down = 1;
+			gpib_device_forget(id, pad);  // might not be the same instrument when it comes back
+			status_add(1, supercat("Warning: GPIB device %d on board %d is not responding. It will be polled less often until it does.\n", pad, id));
+		}
+	}
+}
+
+double poll_timeout (struct GpibHealth *health)
+{
+	// a device that has been answering gets a timeout tailored to its latency; a failing one (i.e., the probe) gets the full timeout
+	if (health->latency < 0.0 || health->N_fail > 0) return M2_GPIB_TIMEOUT;
+	else return min_double(max_double(M2_GPIB_TIMEOUT_FACTOR * health->latency, M2_GPIB_TIMEOUT_MIN), M2_GPIB_TIMEOUT);
+}
+
+bool parse_reply (struct GpibSlot *slot, const char *reply, double *x)
+{
+	char *end;
+	switch (slot->parse_mode)
+	{
+		case GPIB_PARSE_FIELD :
+		{
+			if (str_length(reply) < slot->parse_a + 1) return 0;
+
+			char field [M2_GPIB_BUF_LENGTH];
+			snprintf(field, (size_t) min_int(slot->parse_b + 1, M2_GPIB_BUF_LENGTH), "%s", reply + slot->parse_a);
+			*x = strtod(field, &end);
+			return (end != field);
+		}
+		case GPIB_PARSE_SPLIT :
+		{
+			for (int i = 0; i < slot->parse_a && reply != NULL; i++)
+			{
+				reply = strstr(reply, slot->parse_sep);
+				if (reply != NULL) reply += str_length(slot->parse_sep);
+			}
+			if (reply == NULL) return 0;
+
+			*x = strtod(reply, &end);
+			return (end != reply);
+		}
+		case GPIB_PARSE_NUMBER :
+		{
+			int i = 0;
+			for (const char *c = reply; *c != '\0'; c++)
+			{
+				bool digit_next = isdigit(c[0]) || ((c[0] == '+' || c[0] == '-' || c[0] == '.') && (isdigit(c[1]) || (c[1] == '.' && isdigit(c[2]))));
+				if (!digit_next || (c > reply && (isdigit(c[-1]) || c[-1] == '.'))) continue;  // only at the start of a number
+
+				double value = strtod(c, &end);
+				if (end == c) continue;
+				if (i++ == slot->parse_a)
+				{
+					*x = value;
+					return 1;
+				}
+				c = end - 1;
+			}
+			return 0;
+		}
+		default :
+			return (sscanf(reply, slot->reply_fmt, x) == 1);
+	}
+}
+
 int gpib_multi_tick (int id)
 {
 	f_verify(id >= 0 && id < M2_GPIB_MAX_BRD, GPIB_ID_WARNING_MSG, return 0);
 	f_verify(gpib_board[id].is_connected,     NULL,                return 0);
 
-	struct GpibSlot *slot = pile_first(&gpib_board[id].slots);
-	while (slot != NULL)
+	struct GpibBoard *board = &gpib_board[id];
+
+	size_t N = snapshot(board);  // so that the lock is never held while talking to an instrument
+	double t_start = timer_elapsed(board->clock);
+
+	// writes go first, since the user is waiting on them (a write held back by its rate limit waits for a later tick):
+	double load = 0.0;
+	for (size_t i = 0; i < N; i++)
 	{
-		if (slot->write_request_local)
+		struct GpibSlot *slot = board->queue[i];
+
+		double now = timer_elapsed(board->clock);
+		if (slot->write_request_local && now >= slot->write_next && now >= board->health[slot->pad].retry_at) send_write(board, id, slot);
+
+		if (slot->cost > 0.0 && slot->dt > 0.0 && !board->health[slot->pad].down) load += slot->cost / slot->dt;  // a dead device's timeouts are bounded by its backoff instead
+	}
+
+	// then queries, earliest deadline first within the highest priority that is due. Each round sends
+	// one query to every device that has something due before collecting any reply, so instruments
+	// measure in parallel while the bus moves on to the next one:
+	size_t N_served = 0;
+	while (N_served < N)
+	{
+		double now = timer_elapsed(board->clock);
+		bool busy[M2_GPIB_MAX_PAD] = { 0 };  // one outstanding query per device
+
+		size_t N_batch = 0, N_flight = 0;
+		while (N_served + N_flight < N)
 		{
-			timer_reset(slot->timer);
-			slot->write_request_local = 0;
+			struct GpibSlot *next = NULL;
+			for (size_t i = 0; i < N; i++)
+			{
+				struct GpibSlot *slot = board->queue[i];
+				if (slot->due <= now && now >= board->health[slot->pad].retry_at && !busy[slot->pad] && !slot->write_request_local && (next == NULL || slot->priority > next->priority || (slot->priority == next->priority && slot->due < next->due))) next = slot;
+			}
+			if (next == NULL) break;
+
+			busy[next->pad] = 1;
+			board->batch[N_batch++] = next;
+			N_flight += coalesce(board, next, now, N);
+
+			set_timeout(id, next->pad, poll_timeout(&board->health[next->pad]));
+
+			double t0 = timer_elapsed(board->clock);
+			if (next->group_next == NULL) next->known_local = query_send(id, next->pad, next->cmd, next->cmdlen);
+			else                          next->known_local = query_send(id, next->pad, board->cmd_buf, str_length(board->cmd_buf));
+			next->sent_at = timer_elapsed(board->clock);
+			next->send_time = next->sent_at - t0;
+		}
+		if (N_batch == 0) break;
+
+		for (size_t b = 0; b < N_batch; b++)  // collect replies in the order the queries went out
+		{
+			struct GpibSlot *leader = board->batch[b];
+
+			double t0 = timer_elapsed(board->clock);
+			char *reply = (leader->known_local && leader->dummy_buf == NULL) ? query_receive(id, leader->pad) : NULL;
+			double done = timer_elapsed(board->clock);
+
+			int N_member = 0;
+			for (struct GpibSlot *slot = leader; slot != NULL; slot = slot->group_next) N_member++;
+			double cost = (leader->send_time + (done - t0)) / N_member;  // the first reply of a round also absorbs the wait
+
+			bool sent = leader->known_local;
+			bool answered = sent && (leader->dummy_buf != NULL || str_length(reply) > 0);  // an empty reply means the device timed out
+			board->stats.N_query++;
+			if (!answered) board->stats.N_timeout++;
+			health_update(id, leader->pad, answered, done - leader->sent_at, done);  // upper bound, see health_update()
+
+			struct GpibSlot *slot = leader;
+			while (slot != NULL)
+			{
+				slot->stats.N_query++;
+				if (answered)
+				{
+					slot->stats.send_time  = average(slot->stats.send_time,  leader->send_time);
+					slot->stats.reply_time = average(slot->stats.reply_time, done - t0);  // excludes other devices' sends and reads in this round
+				}
+				else slot->stats.N_timeout++;
 
-			if (!gpib_board[id].is_real) snprintf(slot->dummy_buf, M2_GPIB_BUF_LENGTH, slot->reply_fmt, slot->current_local);
+				if (!sent) slot->known_local = 0;
+				else
+				{
+					if (slot->dummy_buf != NULL) reply = slot->dummy_buf;
+					if (reply == NULL) slot->known_local = 0;
+					else if (reply == slot->dummy_buf) slot->known_local = (sscanf(reply, slot->reply_fmt, &slot->current_local) == 1);
+					else slot->known_local = parse_reply(slot, reply, &slot->current_local);
+					if (slot->known_local)
+					{
+						slot->t_local = done;
+						slot->seq_local++;
+					}
 
-			snprintf(gpib_board[id].buf, M2_GPIB_BUF_LENGTH, slot->write_fmt, slot->current_local);
-			gpib_string_query(id, slot->pad, gpib_board[id].buf, str_length(gpib_board[id].buf), 0);
+					if (slot->dummy_buf == NULL && reply != NULL && slot->group_next != NULL)  // step past this slot's part of a compound reply
+					{
+						reply = strstr(reply, slot->group_sep);
+						if (reply != NULL) reply += str_length(slot->group_sep);
+					}
+				}
+
+				slot->cost = average(slot->cost, cost);
+
+				slot->due += slot->dt;
+				if (slot->due < done)  // a full period behind, so skip ahead rather than trying to catch up
+				{
+					if (slot->dt > 0.0) slot->N_late++;
+					slot->due = done;
+				}
+
+				struct GpibSlot *member = slot->group_next;
+				slot->group_next = NULL;
+				slot = member;
+			}
 		}
-		else if (overtime_then_reset(slot->timer, slot->dt))
+
+		N_served += N_flight;
+
+		mt_mutex_lock(&board->lock);
+		bool interrupted = board->interrupt;
+		mt_mutex_unlock(&board->lock);
+		if (interrupted) break;  // someone is waiting for the bus, the rest stay due for next time
+	}
+
+	// statistics, per window so that rates and utilization follow changes:
+	double now = timer_elapsed(board->clock);
+	board->busy += now - t_start;
+	board->stats.load = load;
+	board->stats.N_slot = (int) N;
+
+	board->stats.N_down = 0;
+	for (int pad = 0; pad < M2_GPIB_MAX_PAD; pad++) if (board->health[pad].down) board->stats.N_down++;
+
+	for (size_t i = 0; i < N; i++)
+	{
+		struct GpibHealth *health = &board->health[board->queue[i]->pad];
+		board->queue[i]->stats.responding = !health->down;
+		board->queue[i]->stats.timeout = timeout_steps[timeout_index(poll_timeout(health))];
+	}
+
+	if (now - board->window_t0 >= M2_GPIB_STATS_WINDOW)
+	{
+		double window = now - board->window_t0;
+		board->stats.utilization = min_double(board->busy / window, 1.0);
+
+		for (size_t i = 0; i < N; i++)
 		{
-			gpib_string_query(id, slot->pad, slot->cmd, slot->cmdlen, 1);  // writes to gpib_board[id].buf automatically
-			slot->known_local = (sscanf(gpib_board[id].is_real ? gpib_board[id].buf : slot->dummy_buf, slot->reply_fmt, &slot->current_local) == 1);
+			struct GpibSlot *slot = board->queue[i];
+			slot->stats.rate = (double) (slot->seq_local - slot->seq_window) / window;
+			slot->seq_window = slot->seq_local;
 		}
 
-		slot = pile_inc(&gpib_board[id].slots);
+		board->busy = 0.0;
+		board->window_t0 = now;
+	}
+
+	if (load > 1.0 && !board->overloaded)
+	{
+		board->overloaded = 1;
+		status_add(1, supercat("Warning: GPIB board %d cannot keep up: the requested polling rates add up to %0.0f%% of the time available. Lower-priority devices will be read less often.\n", id, 100 * load));
+	}
+	else if (load < M2_GPIB_LOAD_RESET && board->overloaded)
+	{
+		board->overloaded = 0;
+		f_print(F_UPDATE, "Info: GPIB board %d is keeping up again (%0.0f%% of the time available).\n", id, 100 * load);
 	}
 
 	return 1;
 }
 
+void gpib_multi_interrupt (int id)
+{
+	f_verify(id >= 0 && id < M2_GPIB_MAX_BRD, GPIB_ID_WARNING_MSG, return);
+
+	mt_mutex_lock(&gpib_board[id].lock);
+	gpib_board[id].interrupt = 1;
+	mt_mutex_unlock(&gpib_board[id].lock);
+}
+
 void gpib_multi_transfer (int id)
 {
 	f_verify(id >= 0 && id < M2_GPIB_MAX_BRD, GPIB_ID_WARNING_MSG, return);
 	f_verify(gpib_board[id].is_connected,     NULL,                return);
 
+	mt_mutex_lock(&gpib_board[id].lock);
+
 	struct GpibSlot *slot = pile_first(&gpib_board[id].slots);
 	while (slot != NULL)
 	{
 		if (slot->write_request_global)
 		{
+			if (slot->write_request_local) slot->N_write_merged++;  // latest value wins
+
 			slot->write_request_global = 0;
 			slot->write_request_local = 1;
 
@@ -165,8 +728,43 @@ void gpib_multi_transfer (int id)
 		{
 			slot->known_global = slot->known_local;
 			slot->current_global = slot->current_local;
+			slot->t_global = slot->t_local;
+			slot->seq_global = slot->seq_local;
 		}
 
+		slot->write_next_global = slot->write_next;
+
+		slot->stats.N_late = slot->N_late;
+		slot->stats.N_write = slot->N_write;
+		slot->stats.N_write_merged = slot->N_write_merged;
+		slot->stats.refs = slot->N_owner;
+		slot->stats_global = slot->stats;
+
 		slot = pile_inc(&gpib_board[id].slots);
 	}
+
+	gpib_board[id].stats_global = gpib_board[id].stats;
+
+	mt_mutex_unlock(&gpib_board[id].lock);
+}
+
+void gpib_multi_flush (int id)
+{
+	f_verify(id >= 0 && id < M2_GPIB_MAX_BRD, GPIB_ID_WARNING_MSG, return);
+	f_verify(gpib_board[id].is_connected,     NULL,                return);
+
+	struct GpibBoard *board = &gpib_board[id];
+
+	size_t N = snapshot(board);
+	for (size_t i = 0; i < N; i++)
+	{
+		struct GpibSlot *slot = board->queue[i];
+		if (slot->write_request_local)
+		{
+			double wait = slot->write_next - timer_elapsed(board->clock);
+			if (wait > 0.0) xleep(wait);
+
+			send_write(board, id, slot);
+		}
+	}
 }
@@ -320,6 +320,12 @@ bool mcf_write_file (const char *filename)
 	return 1;
 }
 
+void set_bool_mcf (bool *ptr, const char *signal_name, MValue value)
+{
+	f_start(F_MCF);
+    if (ptr != NULL) *ptr = value.x_bool;
+}
+
 void set_int_mcf (int *ptr, const char *signal_name, MValue value)
 {
 	f_start(F_MCF);
@@ -55,6 +55,7 @@ int mcf_read_file (const char *filename, const char *signal_name);
 char * mcf_lookup (const char *line);
 bool mcf_write_file (const char *filename);
 
+void set_bool_mcf   (bool   *ptr, const char *signal_name, MValue value);
 void set_int_mcf    (int    *ptr, const char *signal_name, MValue value);
 void set_double_mcf (double *ptr, const char *signal_name, MValue value);
 
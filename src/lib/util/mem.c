@@ -0,0 +1,274 @@
+/*
+ *  Copyright (C) 2012 California Institute of Technology
+ *
+ *  This file is part of Mezurit2, written by Brian Standley <brian@brianstandley.com>.
+ *
+ *  Mezurit2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Foundation,
+ *  either version 3 of the License, or (at your option) any later version.
+ *
+ *  Mezurit2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE. See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with this
+ *  program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _DEFAULT_SOURCE
+#define _DEFAULT_SOURCE  // MAP_ANONYMOUS, madvise()
+#endif
+
+#include "mem.h"
+
+#include <stdlib.h>  // malloc(), getenv(), mkstemp()
+#ifndef MINGW
+#include <unistd.h>
+#include <fcntl.h>   // posix_fallocate()
+#include <sys/mman.h>
+#endif
+
+#include <lib/status.h>
+#include <lib/util/str.h>
+
+typedef struct MemPiece  // header written into a released piece of a MemFile
+{
+	struct MemPiece *next;
+	size_t size;
+
+} MemPiece;
+
+static void * map_block   (size_t size, bool huge, size_t *mapped);
+static void   unmap_block (void *ptr, size_t size);
+static size_t page_round  (size_t size);
+static size_t map_length  (size_t size, bool huge);
+
+void mem_pool_init (MemPool *pool, bool huge, bool prefault)
+{
+	pool->ptr = NULL;
+	pool->size = 0;
+	pool->huge = huge;
+	pool->prefault = prefault;
+	pool->recent_index = 0;
+	pool->recent_filled = 0;
+}
+
+void * mem_pool_get (MemPool *pool, size_t size)
+{
+	// Keep the block sized to the largest of the recent requests, so repeated scans never
+	// reallocate, but one unusually large scan does not pin that much memory forever.
+
+	pool->recent[pool->recent_index] = size;
+	pool->recent_index = (pool->recent_index + 1) % M2_MEM_POOL_HISTORY;
+	if (pool->recent_filled < M2_MEM_POOL_HISTORY) pool->recent_filled++;
+
+	size_t target = 0;
+	for (int i = 0; i < pool->recent_filled; i++)
+		if (pool->recent[i] > target) target = pool->recent[i];
+
+	// compare with what map_block() would map for target, since hugepages round up to 2 MB
+	if (pool->ptr != NULL && size <= pool->size && pool->size <= 2 * map_length(target, pool->huge)) return pool->ptr;
+
+	unmap_block(pool->ptr, pool->size);
+	pool->ptr = map_block(target, pool->huge, &pool->size);
+
+	if (pool->ptr != NULL && pool->prefault)  // touch every page now, rather than during acquisition
+	{
+#ifndef MINGW
+		size_t page = (size_t) sysconf(_SC_PAGE_SIZE);
+#else
+		size_t page = 4096;
+#endif
+		for (size_t i = 0; i < pool->size; i += page) ((volatile char *) pool->ptr)[i] = 0;
+	}
+
+	f_print(F_VERBOSE, "Pool block: %zu bytes (%zu requested).\n", pool->size, size);
+	return pool->ptr;
+}
+
+void mem_pool_final (MemPool *pool)
+{
+	unmap_block(pool->ptr, pool->size);
+	pool->ptr = NULL;
+	pool->size = 0;
+}
+
+void * map_block (size_t size, bool huge, size_t *mapped)
+{
+	*mapped = 0;
+	if (size == 0) return NULL;
+
+#ifndef MINGW
+	void *ptr = MAP_FAILED;
+
+#ifdef MAP_HUGETLB
+	if (huge)  // needs pages reserved through vm.nr_hugepages
+	{
+		size_t length = map_length(size, 1);
+		ptr = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+		if (ptr != MAP_FAILED) *mapped = length;
+	}
+#endif
+
+	if (ptr == MAP_FAILED)
+	{
+		size_t length = page_round(size);
+		ptr = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (ptr == MAP_FAILED) return NULL;
+		*mapped = length;
+
+#ifdef MADV_HUGEPAGE
+		if (huge) madvise(ptr, length, MADV_HUGEPAGE);  // fall back on transparent hugepages
+#endif
+	}
+
+	return ptr;
+#else
+	void *ptr = malloc(size);
+	if (ptr != NULL) *mapped = size;
+	return ptr;
+#endif
+}
+
+void unmap_block (void *ptr, size_t size)
+{
+	if (ptr == NULL) return;
+
+#ifndef MINGW
+	munmap(ptr, size);
+#else
+	free(ptr);
+#endif
+}
+
+size_t page_round (size_t size)
+{
+#ifndef MINGW
+	size_t page = (size_t) sysconf(_SC_PAGE_SIZE);
+#else
+	size_t page = 4096;
+#endif
+	return (size + page - 1) / page * page;
+}
+
+size_t map_length (size_t size, bool huge)
+{
+#if !defined(MINGW) && defined(MAP_HUGETLB)
+	if (huge) return (size + M2_MEM_HUGEPAGE_SIZE - 1) / M2_MEM_HUGEPAGE_SIZE * M2_MEM_HUGEPAGE_SIZE;
+#endif
+	return page_round(size);
+}
+
+void mem_file_init (MemFile *file)
+{
+	file->fd = -1;
+	file->size = 0;
+	file->failed = 0;
+
+	file->extent = NULL;
+	file->extent_size = NULL;
+	file->N_extent = 0;
+	file->extent_used = 0;
+
+	file->free_list = NULL;
+	file->N_live = 0;
+}
+
+bool mem_file_open (MemFile *file, const char *dir)
+{
+	if (file->fd != -1) return 1;
+	if (file->failed) return 0;
+
+#ifndef MINGW
+	if (str_length(dir) == 0) dir = getenv("TMPDIR");
+	if (str_length(dir) == 0) dir = "/tmp";
+
+	char *path _strfree_ = supercat("%s/mezurit2-XXXXXX", dir);
+	file->fd = mkstemp(path);
+	if (file->fd != -1)
+	{
+		unlink(path);  // see notes in mem.h
+		file->size = 0;
+		return 1;
+	}
+
+	f_print(F_ERROR, "Error: Unable to create a scratch file in \"%s\".\n", dir);
+#endif
+	file->failed = 1;
+	return 0;
+}
+
+void * mem_file_alloc (MemFile *file, size_t size)
+{
+#ifndef MINGW
+	if (file->fd == -1 || size == 0) return NULL;
+
+	size_t length = page_round(size);  // keeps every piece page-aligned within the file
+
+	for (MemPiece **link = (MemPiece **) &file->free_list; *link != NULL; link = &(*link)->next)
+		if ((*link)->size == length)
+		{
+			MemPiece *piece = *link;
+			*link = piece->next;
+			file->N_live++;
+			return piece;
+		}
+
+	if (file->N_extent == 0 || file->extent_used + length > file->extent_size[file->N_extent - 1])
+	{
+		if (file->failed) return NULL;
+
+		size_t extent_length = (length > M2_MEM_FILE_EXTENT) ? length : page_round(M2_MEM_FILE_EXTENT);
+		void **extent = realloc(file->extent, sizeof(void *) * (size_t) (file->N_extent + 1));
+		if (extent != NULL) file->extent = extent;
+		size_t *extent_size = realloc(file->extent_size, sizeof(size_t) * (size_t) (file->N_extent + 1));
+		if (extent_size != NULL) file->extent_size = extent_size;
+
+		void *ptr = MAP_FAILED;
+		if (extent != NULL && extent_size != NULL && posix_fallocate(file->fd, (off_t) file->size, (off_t) extent_length) == 0)
+			ptr = mmap(NULL, extent_length, PROT_READ | PROT_WRITE, MAP_SHARED, file->fd, (off_t) file->size);
+
+		if (ptr == MAP_FAILED)
+		{
+			f_print(F_WARNING, "Warning: Unable to extend a scratch file beyond %zu bytes (disk full?).\n", file->size);
+			file->failed = 1;
+			return NULL;
+		}
+
+		file->size += extent_length;
+		file->extent[file->N_extent] = ptr;
+		file->extent_size[file->N_extent] = extent_length;
+		file->N_extent++;
+		file->extent_used = 0;  // the unused end of the previous extent is given up
+	}
+
+	void *ptr = (char *) file->extent[file->N_extent - 1] + file->extent_used;
+	file->extent_used += length;
+	file->N_live++;
+	return ptr;
+#else
+	return NULL;
+#endif
+}
+
+void mem_file_release (MemFile *file, void *ptr, size_t size)
+{
+	if (ptr == NULL) return;
+
+	MemPiece *piece = ptr;
+	piece->size = page_round(size);
+	piece->next = file->free_list;
+	file->free_list = piece;
+	file->N_live--;
+}
+
+void mem_file_close (MemFile *file)
+{
+	for (int e = 0; e < file->N_extent; e++) unmap_block(file->extent[e], file->extent_size[e]);
+	free(file->extent);
+	free(file->extent_size);
+#ifndef MINGW
+	if (file->fd != -1) close(file->fd);
+#endif
+	mem_file_init(file);  // the next mem_file_open() starts afresh
+}
@@ -0,0 +1,76 @@
+/*
+ *  Copyright (C) 2012 California Institute of Technology
+ *
+ *  This file is part of Mezurit2, written by Brian Standley <brian@brianstandley.com>.
+ *
+ *  Mezurit2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Foundation,
+ *  either version 3 of the License, or (at your option) any later version.
+ *
+ *  Mezurit2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE. See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with this
+ *  program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _LIB_UTIL_MEM_H
+#define _LIB_UTIL_MEM_H 1
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <config.h>
+
+typedef struct  // a single large block, reused for as long as it fits the recent requests
+{
+	void *ptr;
+	size_t size;  // bytes actually mapped
+	bool huge, prefault;
+
+	size_t recent[M2_MEM_POOL_HISTORY];
+	int recent_index, recent_filled;
+
+} MemPool;
+
+void   mem_pool_init  (MemPool *pool, bool huge, bool prefault);
+void * mem_pool_get   (MemPool *pool, size_t size);  // contents undefined, valid until the next call to mem_pool_get() or mem_pool_final()
+void   mem_pool_final (MemPool *pool);
+
+typedef struct  // a scratch file that is mapped into memory in large extents, and handed out in pieces
+{
+	int fd;       // -1 if not open
+	size_t size;  // bytes allocated so far
+	bool failed;  // set once the file could not be created or grown, after which it is not tried again
+
+	void **extent;         // mapped regions of the file, unmapped only by mem_file_close()
+	size_t *extent_size;
+	int N_extent;
+	size_t extent_used;    // bytes handed out from the last extent
+
+	void *free_list;       // released pieces, linked through their own first bytes
+	long N_live;           // pieces handed out and not yet released
+
+} MemFile;
+
+void   mem_file_init    (MemFile *file);
+bool   mem_file_open    (MemFile *file, const char *dir);  // dir may be NULL or empty, see M2_BUFFER_SCRATCH_DIR
+void * mem_file_alloc   (MemFile *file, size_t size);      // page-aligned, NULL on failure
+void   mem_file_release (MemFile *file, void *ptr, size_t size);  // pass the size given to mem_file_alloc()
+void   mem_file_close   (MemFile *file);                   // unmaps everything, so only call once N_live is 0
+
+// Notes on MemFile:
+//
+//   The file is unlinked as soon as it is created, so its disk space is released when it is
+//   closed, or when the program exits for any reason. Regions are shared mappings, which the
+//   kernel writes back and evicts like any other page cache, so only recently touched pieces
+//   occupy RAM. Disk space is reserved with posix_fallocate() before mapping, so that a full
+//   disk is reported as a failed allocation rather than as SIGBUS on a later write.
+//
+//   Pieces are carved from extents of M2_MEM_FILE_EXTENT bytes (or one piece, if larger), so
+//   a long run needs only a few mappings, well below vm.max_map_count. A released piece stays
+//   mapped and is handed out again by the next mem_file_alloc() of the same size. MemFile
+//   does no locking of its own. Not available on Windows (opening always fails).
+
+#endif
@@ -17,7 +17,8 @@
 
 #include "setvarset.h"
 
-#include <stdlib.h>  // malloc(), free()
+#include <stdlib.h>  // malloc(), realloc(), free()
+#include <string.h>  // memcpy()
 
 #ifdef STATUS
 #include <lib/status.h>
@@ -42,6 +43,8 @@ SVSP new_svset (void)
 		svs->data_saved = 0;
 		svs->data = NULL;
 		svs->last_vs = NULL;
+		svs->retired = NULL;
+		svs->N_retired = 0;
 	}
 
 	return svs;
@@ -49,10 +52,32 @@ SVSP new_svset (void)
 
 void svset_alloc_chunk (SVSP svs)
 {
-	svs->chunks++;
-	svs->data = realloc(svs->data, sizeof(VSP) * SPEEDYPROC_SETVARSET_CHUNK_SIZE * (size_t) svs->chunks);
+	// copy rather than realloc(), since a reader may still be using the old array (see alloc_block() in varset.c)
+
+	VSP *data = malloc(sizeof(VSP) * SPEEDYPROC_SETVARSET_CHUNK_SIZE * (size_t) (svs->chunks + 1));
+	if (data == NULL)
+	{
+		f_print(F_ERROR, "Error: malloc() failed!\n");
+		return;
+	}
+
+	if (svs->data != NULL)
+	{
+		void **retired = realloc(svs->retired, sizeof(void *) * (size_t) (svs->N_retired + 1));
+		if (retired == NULL)
+		{
+			f_print(F_ERROR, "Error: realloc() failed!\n");
+			free(data);
+			return;
+		}
+
+		memcpy(data, svs->data, sizeof(VSP) * (size_t) svs->N_set);
+		retired[svs->N_retired++] = svs->data;
+		svs->retired = retired;
+	}
 
-	if (svs->data == NULL) f_print(F_ERROR, "Error: realloc() failed!\n");
+	svs->chunks++;
+	__atomic_store_n(&svs->data, data, __ATOMIC_RELEASE);
 }
 
 SVSP append_vset (SVSP svs, VSP vs)
@@ -60,12 +85,23 @@ SVSP append_vset (SVSP svs, VSP vs)
 	if (svs->N_set == svs->chunks * SPEEDYPROC_SETVARSET_CHUNK_SIZE)  // might need to allocate another chunk
 		svset_alloc_chunk(svs);
 
-	svs->N_set++;
-	svs->data[svs->N_set - 1] = svs->last_vs = vs;  // don't free vs later or else it will disappear here too
+	if (svs->N_set < svs->chunks * SPEEDYPROC_SETVARSET_CHUNK_SIZE)
+	{
+		svs->data[svs->N_set] = svs->last_vs = vs;  // don't free vs later or else it will disappear here too
+		__atomic_store_n(&svs->N_set, svs->N_set + 1, __ATOMIC_RELEASE);
+	}
 
 	return svs;
 }
 
+VSP svs_vset (SVSP svs, int j)
+{
+	if (svs == NULL || j < 0 || j >= svs_published(svs)) return NULL;
+
+	VSP *data = __atomic_load_n(&svs->data, __ATOMIC_ACQUIRE);
+	return data[j];
+}
+
 void free_svset (SVSP svs)
 {
 	if (svs != NULL)
@@ -75,6 +111,8 @@ void free_svset (SVSP svs)
 				free_vset(svs->data[j]);
 
 		free(svs->data);
+		for (int r = 0; r < svs->N_retired; r++) free(svs->retired[r]);
+		free(svs->retired);
 		free(svs);
 	}
 }
@@ -83,9 +121,10 @@ bool unsaved_data (SVSP svs)
 {
 	if (svs != NULL)
 	{
-		for (int j = 0; j < svs->N_set; j++)
-			if (svs->data[j]->N_pt > 0 && !svs->data[j]->data_saved)
-				return 1;
+		int N_set = svs_published(svs);  // load before data, see append_vset()
+		VSP *data = __atomic_load_n(&svs->data, __ATOMIC_ACQUIRE);
+		for (int j = 0; j < N_set; j++)
+			if (vs_published(data[j]) > data[j]->N_saved) return 1;
 	}
 
 	return 0;
@@ -94,8 +133,10 @@ bool unsaved_data (SVSP svs)
 long total_pts (SVSP svs)
 {
 	long total = 0;
-	for (int j = 0; j < svs->N_set; j++)
-		total += svs->data[j]->N_pt;
+	int N_set = svs_published(svs);
+	VSP *data = __atomic_load_n(&svs->data, __ATOMIC_ACQUIRE);
+	for (int j = 0; j < N_set; j++)
+		total += vs_published(data[j]);
 
 	return total;
 }
@@ -105,8 +146,10 @@ long write_svset_custom (SVSP svs, int *vci, int vci_len, const char *filename,
 	// will return <0 on error
 
 	long N_written = 0;
-	for (int j = 0; j < svs->N_set; j++)
-		N_written += write_vset_custom(svs->data[j], vci, vci_len, filename, save_col_names, always_append || j != 0, overwrite);
+	int N_set = svs_published(svs);
+	VSP *data = __atomic_load_n(&svs->data, __ATOMIC_ACQUIRE);
+	for (int j = 0; j < N_set; j++)
+		N_written += write_vset_custom(data[j], vci, vci_len, filename, save_col_names, always_append || j != 0, overwrite);
 
 #ifdef STATUS
 	status_add(1, supercat("Wrote %ld total points to \"%s\".\n", N_written, filename));
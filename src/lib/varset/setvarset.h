@@ -22,9 +22,12 @@
 
 typedef struct
 {
-	int N_set, chunks;
+	int N_set, chunks;      // N_set is published like VarSet.N_pt
 	bool data_saved;
-	VSP *data, last_vs;
+	VSP *data, last_vs;     // last_vs is for the writer, readers should use svs_vset()
+
+	void **retired;         // outgrown data arrays, kept for readers until free_svset()
+	int N_retired;
 
 } SetVarSet;
 
@@ -34,9 +37,16 @@ SVSP new_svset   (void);
 void free_svset  (SVSP svs);
 SVSP append_vset (SVSP svs, VSP vs);
 
+#define svs_published(SVS) __atomic_load_n(&(SVS)->N_set, __ATOMIC_ACQUIRE)
+VSP svs_vset (SVSP svs, int j);  // returns NULL unless 0 <= j < svs_published(svs)
+
 bool unsaved_data (SVSP svs);
 long total_pts    (SVSP svs);
 
 long write_svset_custom (SVSP svs, int *vci, int vci_len, const char *filename, bool save_col_names, bool always_append, bool overwrite);
 
+// Note: Sets are published by append_vset() the same way points are published by append_point()
+//       (see varset.h), so unsaved_data(), total_pts(), write_svset_custom() and svs_vset() are
+//       safe to call while another thread appends sets or points.
+
 #endif
@@ -19,7 +19,7 @@
 
 #include <stdlib.h>  // malloc(), realloc(), free()
 #include <stdio.h>
-#include <string.h>  // strtok()
+#include <string.h>  // strtok(), memcpy()
 
 #ifdef STATUS
 #include <lib/status.h>
@@ -28,19 +28,93 @@
 #endif
 #include <lib/util/str.h>
 #include <lib/util/num.h>
+#include <lib/util/mem.h>
+#include <lib/util/mt.h>
 
 #define SPEEDYPROC_LINE_LENGTH 1024
-#define SPEEDYPROC_VARSET_CHUNK_SIZE 1024
+#define SPEEDYPROC_VARSET_INDEX_SIZE 16
 
-static void alloc_chunk       (VSP vs);
+static char *spill_dir = NULL;
+static int64_t spill_budget = -1;     // bytes
+static int64_t heap_used = 0;         // bytes of heap held by blocks, all VarSets (updated atomically)
+static MemFile spill = { .fd = -1 };  // shared by all VarSets, see notes in varset.h
+static MtMutex spill_mutex;           // guards spill (statically allocated, so needs no init)
+
+static size_t block_size      (VSP vs);
+static long block_offset      (VSP vs, long row, int col);
+static void alloc_block       (VSP vs);
 static void parse_point       (VSP vs, char *str);  // Note: str will be modified
 static bool parse_heading     (VSP vs, char *str);  // Note: str will be modified
-static void append_value      (VSP vs, long new_pt, int c, double value);
 static long write_vset_actual (VSP vs, int *vci, int vci_len, FILE *file, bool headings);
 
+void vs_spill_config (const char *dir, int64_t budget)
+{
+	replace(spill_dir, cat1(dir));
+	spill_budget = budget;
+}
+
+size_t block_size (VSP vs)
+{
+	return sizeof(double) * (size_t) vs->N_col * VARSET_BLOCK_SIZE;
+}
+
+long block_offset (VSP vs, long row, int col)
+{
+	long offset = row & (VARSET_BLOCK_SIZE - 1);
+	return vs->columnar ? col * VARSET_BLOCK_SIZE + offset : offset * vs->N_col + col;
+}
+
 double * vs_ref (VSP vs, long row, int col)
 {
-	return (row < vs->N_pt && col < vs->N_col) ? &vs->data[row * vs->N_col + col] : NULL;
+	if (row < 0 || row >= vs_published(vs) || col < 0 || col >= vs->N_col) return NULL;
+
+	double **block = __atomic_load_n(&vs->block, __ATOMIC_ACQUIRE);  // at least as new as the published N_pt
+	return &block[row >> VARSET_BLOCK_SHIFT][block_offset(vs, row, col)];
+}
+
+long vs_walk (VSP vs, long row, long end, int col, const double **data, int *stride)
+{
+	end = min_long(end, vs_published(vs));
+	if (row < 0 || row >= end || col < 0 || col >= vs->N_col) return 0;
+
+	double **block = __atomic_load_n(&vs->block, __ATOMIC_ACQUIRE);
+	*data = &block[row >> VARSET_BLOCK_SHIFT][block_offset(vs, row, col)];
+	*stride = vs->columnar ? 1 : vs->N_col;
+
+	return min_long(end - row, VARSET_BLOCK_SIZE - (row & (VARSET_BLOCK_SIZE - 1)));
+}
+
+long vs_range (VSP vs, long row, long end, int col, double *min, double *max)
+{
+	long N = 0;
+	const double *data;
+	int stride;
+	for (long n; (n = vs_walk(vs, row, end, col, &data, &stride)) > 0; row += n)
+	{
+		double lo = (N == 0) ? data[0] : *min;
+		double hi = (N == 0) ? data[0] : *max;
+
+		if (stride == 1)  // columnar layout: plain contiguous loop, which the compiler can vectorize
+		{
+			for (long k = 0; k < n; k++)
+			{
+				lo = (data[k] < lo) ? data[k] : lo;
+				hi = (data[k] > hi) ? data[k] : hi;
+			}
+		}
+		else for (long k = 0; k < n; k++)
+		{
+			double value = data[k * stride];
+			lo = (value < lo) ? value : lo;
+			hi = (value > hi) ? value : hi;
+		}
+
+		*min = lo;
+		*max = hi;
+		N += n;
+	}
+
+	return N;
 }
 
 VSP new_vset (int N_col)
@@ -51,10 +125,14 @@ VSP new_vset (int N_col)
 	else
 	{
 		vs->N_col = N_col;
+		vs->columnar = 0;
 		vs->N_pt = 0;
-		vs->chunks = 0;
-		vs->data_saved = 0;
-		vs->data = NULL;
+		vs->N_saved = 0;
+		vs->block = NULL;
+		vs->N_block = vs->N_index = 0;
+		vs->retired = NULL;
+		vs->N_retired = 0;
+		vs->spilled = NULL;
 		vs->name = cat1("none");
 
 		if (N_col > 0)
@@ -94,6 +172,7 @@ VSP clone_vset (VSP vs, long N_pt)
 	VSP cp = new_vset(vs->N_col);
 
 	set_name(cp, vs->name);
+	set_columnar(cp, vs->columnar);
 	for (int i = 0; i < vs->N_col; i++)
 	{
 		set_colname(cp, i, vs->colname[i]);
@@ -101,9 +180,15 @@ VSP clone_vset (VSP vs, long N_pt)
 		set_colsave(cp, i, vs->colsave[i]);
 	}
 
-	N_pt = (N_pt == -1) ? vs->N_pt : min_long(vs->N_pt, N_pt);
+	N_pt = (N_pt == -1) ? vs_published(vs) : min_long(vs_published(vs), N_pt);
+	double pt[vs->N_col];
 	for (long j = 0; j < N_pt; j++)
-		append_point(cp, vs_ref(vs, j, 0));
+	{
+		for (int i = 0; i < vs->N_col; i++)
+			pt[i] = vs_value(vs, j, i);
+
+		append_point(cp, pt);
+	}
 
 	return cp;
 }
@@ -123,7 +208,22 @@ void free_vset (VSP vs)
 	free(vs->colunit);
 	free(vs->colsave);
 
-	free(vs->data);
+	mt_mutex_lock(&spill_mutex);
+	for (long b = 0; b < vs->N_block; b++)
+	{
+		if (vs->spilled[b]) mem_file_release(&spill, vs->block[b], block_size(vs));
+		else
+		{
+			free(vs->block[b]);
+			__atomic_sub_fetch(&heap_used, (int64_t) block_size(vs), __ATOMIC_RELAXED);
+		}
+	}
+	if (spill.fd != -1 && spill.N_live == 0) mem_file_close(&spill);  // gives the disk space back
+	mt_mutex_unlock(&spill_mutex);
+	free(vs->spilled);
+	free(vs->block);
+	for (int r = 0; r < vs->N_retired; r++) free(vs->retired[r]);
+	free(vs->retired);
 	free(vs);
 }
 
@@ -159,6 +259,14 @@ bool set_colsave (VSP vs, int i, bool save)
 	return 1;
 }
 
+bool set_columnar (VSP vs, bool columnar)
+{
+	if (vs == NULL || vs->N_block > 0) return 0;  // the layout of existing blocks cannot change
+
+	vs->columnar = columnar;
+	return 1;
+}
+
 char * get_name (VSP vs)
 {
 	return (vs == NULL) ? NULL : vs->name;
@@ -179,36 +287,89 @@ bool get_colsave (VSP vs, int i)
 	return (vs == NULL || i < 0 || i >= vs->N_col) ? 1 : vs->colsave[i];
 }
 
-void alloc_chunk (VSP vs)
+void alloc_block (VSP vs)
 {
-	vs->chunks++;
-	vs->data = realloc(vs->data, sizeof(double) * (size_t) vs->N_col * SPEEDYPROC_VARSET_CHUNK_SIZE * (size_t) vs->chunks);
+	// Only the (small) block index is ever replaced, and it doubles each time, so the
+	// cost of growing is O(1) per point and existing points stay where they are. A reader
+	// may still be looking at the old index, so it is retired rather than freed.
 
-	if (vs->data == NULL) f_print(F_ERROR, "Error: malloc() failed!\n");
-}
+	if (vs->N_block == vs->N_index)
+	{
+		long N_index = (vs->N_index > 0) ? 2 * vs->N_index : SPEEDYPROC_VARSET_INDEX_SIZE;
+		double **block = malloc(sizeof(double *) * (size_t) N_index);
+		bool *spilled = realloc(vs->spilled, sizeof(bool) * (size_t) N_index);  // only the writer looks at this one
+		if (block == NULL || spilled == NULL)
+		{
+			f_print(F_ERROR, "Error: malloc() failed!\n");
+			free(block);
+			if (spilled != NULL) vs->spilled = spilled;
+			return;
+		}
+		vs->spilled = spilled;
 
-void append_value (VSP vs, long new_pt, int c, double value)
-{
-	if (new_pt)
+		if (vs->block != NULL)
+		{
+			void **retired = realloc(vs->retired, sizeof(void *) * (size_t) (vs->N_retired + 1));
+			if (retired == NULL)
+			{
+				f_print(F_ERROR, "Error: realloc() failed!\n");
+				free(block);
+				return;
+			}
+
+			memcpy(block, vs->block, sizeof(double *) * (size_t) vs->N_block);
+			retired[vs->N_retired++] = vs->block;
+			vs->retired = retired;
+		}
+
+		vs->N_index = N_index;
+		__atomic_store_n(&vs->block, block, __ATOMIC_RELEASE);
+	}
+
+	size_t size = block_size(vs);
+	double *block = NULL;
+	if (spill_budget >= 0 && __atomic_load_n(&heap_used, __ATOMIC_RELAXED) + (int64_t) size > spill_budget)
+	{
+		mt_mutex_lock(&spill_mutex);
+		if (spill.fd == -1 && mem_file_open(&spill, spill_dir)) f_print(F_RUN, "RAM budget reached, new buffer points go to a scratch file.\n");
+		block = mem_file_alloc(&spill, size);
+		mt_mutex_unlock(&spill_mutex);
+	}
+	vs->spilled[vs->N_block] = (block != NULL);
+
+	if (block == NULL)  // not spilling, or the scratch file is full
 	{
-		if (vs->N_pt == SPEEDYPROC_VARSET_CHUNK_SIZE * vs->chunks) alloc_chunk(vs);  // might need to allocate another chunk
-		vs->N_pt++;
+		block = malloc(size);
+		if (block != NULL) __atomic_add_fetch(&heap_used, (int64_t) size, __ATOMIC_RELAXED);
 	}
 
-	vs_value(vs, vs->N_pt - 1, c) = value;  // write to the last point
+	vs->block[vs->N_block] = block;
+
+	if (block == NULL) f_print(F_ERROR, "Error: malloc() failed!\n");
+	else vs->N_block++;
 }
 
-void append_point (VSP vs, double *pt)
+void append_point (VSP vs, double *pt)  // pt better have the right length
 {
+	long row = vs->N_pt;  // only the writer changes N_pt, so no need to load it atomically
+	if (row == VARSET_BLOCK_SIZE * vs->N_block) alloc_block(vs);  // might need to allocate another block
+	if (row == VARSET_BLOCK_SIZE * vs->N_block) return;           // allocation failed, already reported
+
+	double *dest = vs->block[row >> VARSET_BLOCK_SHIFT];
 	for (int i = 0; i < vs->N_col; i++)
-		append_value(vs, i == 0, i, pt[i]);  // pt better have the right length
+		dest[block_offset(vs, row, i)] = pt[i];
+
+	__atomic_store_n(&vs->N_pt, row + 1, __ATOMIC_RELEASE);  // publish the point only once it is complete
 }
 
 void parse_point (VSP vs, char *str)  // note: str will be modified
 {
+	double pt[vs->N_col];
 	for (int i = 0; i < vs->N_col; i++)
-		append_value(vs, i == 0, i, atof(strtok(i == 0 ? str : NULL, "\t")));
-}	
+		pt[i] = atof(strtok(i == 0 ? str : NULL, "\t"));
+
+	append_point(vs, pt);
+}
 
 bool parse_heading (VSP vs, char *str)
 {
@@ -334,8 +495,8 @@ long write_vset_custom (VSP vs, int *vci, int vci_len, const char *filename, boo
 			N_written = write_vset_actual(vs, vci, vci_len, file, save_col_names && !(exists && append));  // include exists in case we accidentially append to an empty file
 
 			fclose(file);
-			vs->data_saved = 1;
-			f_print(F_RUN, "Wrote %ld points to \"%s\".\n", vs->N_pt, filename);
+			vs->N_saved = N_written;
+			f_print(F_RUN, "Wrote %ld points to \"%s\".\n", N_written, filename);
 		}
 	}
 
@@ -351,9 +512,22 @@ long write_vset_actual (VSP vs, int *vci, int vci_len, FILE *file, bool headings
 			fprintf(file, "%s (%s)%c", vs->colname[vci[i]], vs->colunit[vci[i]], i == vci_len - 1 ? '\n' : '\t');
 	}
 
-	for (long j = 0; j < vs->N_pt; j++)
-		for (int i = 0; i < vci_len; i++)
-			fprintf(file, "%1.10f%c", vs_value(vs, j, vci[i]), i == vci_len - 1 ? '\n' : '\t');
+	long N_pt = vs_published(vs);  // points appended while we write will go out next time
+
+	if (vci_len > 0)
+	{
+		const double *data[vci_len];  // one pointer per saved column, so either layout works
+		int stride[vci_len];
+		for (long j = 0, n; (n = vs_walk(vs, j, N_pt, vci[0], &data[0], &stride[0])) > 0; j += n)  // a block at a time
+		{
+			for (int i = 1; i < vci_len; i++)
+				vs_walk(vs, j, N_pt, vci[i], &data[i], &stride[i]);
+
+			for (long k = 0; k < n; k++)
+				for (int i = 0; i < vci_len; i++)
+					fprintf(file, "%1.10f%c", data[i][k * stride[i]], i == vci_len - 1 ? '\n' : '\t');
+		}
+	}
 
-	return vs->N_pt;
+	return N_pt;
 }
@@ -19,23 +19,36 @@
 #define _LIB_VARSET_VARSET_H 1
 
 #include <stdbool.h>
+#include <stdint.h>
 
 typedef struct
 {
 	char *name;
-	long N_pt, chunks;
-	bool data_saved;
+	long N_pt;              // published point count, see notes below
+	long N_saved;           // points written by the last write_vset_custom()
 
 	int N_col;
 	char **colname, **colunit;
 	bool *colsave;
+	bool columnar;          // layout within each block, see notes on vs_walk()
 
-	double *data;
+	double **block;         // VARSET_BLOCK_SIZE points each, never moved once allocated
+	long N_block, N_index;  // blocks allocated, room in the block index
+
+	void **retired;         // outgrown block indices, kept for readers until free_vset()
+	int N_retired;
+
+	bool *spilled;          // per block, mapped from the scratch file (see vs_spill_config()), writer only
 
 } VarSet;
 
+#define VARSET_BLOCK_SHIFT 10
+#define VARSET_BLOCK_SIZE  (1L << VARSET_BLOCK_SHIFT)
+
 typedef VarSet (* VSP);
 
+void vs_spill_config (const char *dir, int64_t budget);  // budget in bytes, < 0 to never spill
+
 VSP  new_vset     (int N_col);
 VSP  clone_vset   (VSP vs, long N_pt);  // pass N_pt = -1 to copy all points
 void append_point (VSP vs, double *pt);
@@ -45,6 +58,7 @@ bool set_name    (VSP vs, const char *str);
 bool set_colname (VSP vs, int i, const char *name);
 bool set_colunit (VSP vs, int i, const char *unit);
 bool set_colsave (VSP vs, int i, bool save);
+bool set_columnar (VSP vs, bool columnar);  // only before the first point is appended
 
 char * get_name    (VSP vs);
 char * get_colname (VSP vs, int i);
@@ -53,10 +67,57 @@ bool   get_colsave (VSP vs, int i);  // returns 1 if out-of-range
 
 // Note: get_name(), get_colname(), get_colunit() return internal strings (do not free).
 
+#define vs_published(VS) __atomic_load_n(&(VS)->N_pt, __ATOMIC_ACQUIRE)
+
 double * vs_ref (VSP vs, long row, int col);
 #define vs_value(VS, ROW, COL) (*vs_ref(VS, ROW, COL))
 
+long vs_walk  (VSP vs, long row, long end, int col, const double **data, int *stride);  // see below
+long vs_range (VSP vs, long row, long end, int col, double *min, double *max);          // returns number of points examined, min and max untouched if none
+
 VSP read_vset_range (const char *filename, long skip, long total);
 long write_vset_custom (VSP vs, int *vci, int vci_len, const char *filename, bool save_col_names, bool append, bool overwrite);
 
+// Notes on vs_walk():
+//
+//   Points are stored in blocks of VARSET_BLOCK_SIZE, so that appending never moves
+//   existing points. vs_walk() returns how many points from row up to (but not including)
+//   end lie in the same block, and sets *data to the value of column col in point row,
+//   with the following points *stride doubles apart. It returns 0 when row >= end, or if
+//   row or col is out of range.
+//
+//   Within a block, points are either interleaved (the default, *stride == N_col), or, if
+//   set_columnar() was called on the empty VarSet, each column is contiguous (*stride == 1),
+//   which is kinder to the cache when only one or two of many columns are read. Callers
+//   that go through vs_walk() or vs_ref() work with either layout. Typical use:
+//
+//      const double *x;
+//      int stride;
+//      for (long j = begin, n; (n = vs_walk(vs, j, end, col, &x, &stride)) > 0; j += n)
+//          for (long k = 0; k < n; k++) sum += x[k * stride];
+
+// Notes on vs_spill_config():
+//
+//   Blocks are normally allocated on the heap. Once the blocks of all VarSets together would
+//   exceed the budget, each new block is instead taken from a single scratch file in dir,
+//   shared by all VarSets (see MemFile in mem.h). Those blocks never move either, so readers
+//   cannot tell the difference, and the page cache keeps only the recently written and
+//   recently read blocks in RAM. If the file cannot be created or grown, blocks come from the
+//   heap after all. The file is closed, and its disk space freed, when its last block goes
+//   with free_vset(). The configuration is process-wide and should only be changed while no
+//   VarSet is being appended to.
+
+// Notes on vs_published():
+//
+//   A VarSet has a single writer (whoever calls append_point()) and any number of readers
+//   in other threads. The writer fills in a point before storing the new N_pt with release
+//   semantics, and readers load it with vs_published(), which has acquire semantics, so
+//   every point below the returned count is complete and will not move. vs_ref(), vs_walk(),
+//   clone_vset() and write_vset_custom() only ever see published points, and none of them
+//   needs a lock. Readers should take their count from vs_published() rather than N_pt.
+//
+//   What the protocol does not cover: changing names, units or colsave[], and free_vset(),
+//   which must be kept away from readers by other means. Two threads appending to the same
+//   VarSet must also be serialized by the caller.
+
 #endif
@@ -20,6 +20,9 @@
 #include <lib/status.h>
 #include <lib/mcf2.h>
 #include <lib/gui.h>
+#include <lib/util/str.h>
+#include <lib/util/num.h>
+#include <lib/varset/varset.h>
 
 #include "bufmenu_callback.c"
 
@@ -37,6 +40,9 @@ void bufmenu_init (Bufmenu *bufmenu, GtkWidget *menubar)
 
 	gtk_widget_set_sensitive(bufmenu->save_mcf_item, 0);
 	gtk_widget_set_sensitive(bufmenu->save_scr_item, 0);
+
+	bufmenu->ram_budget = M2_BUFFER_RAM_BUDGET_MB;
+	bufmenu->scratch_dir = cat1(M2_BUFFER_SCRATCH_DIR);
 }
 
 void bufmenu_register (Bufmenu *bufmenu)
@@ -47,11 +53,15 @@ void bufmenu_register (Bufmenu *bufmenu)
 	int save_header_var = mcf_register(&bufmenu->save_header, "save_channel_names",        MCF_BOOL | MCF_W | MCF_DEFAULT, 1);
 	int save_mcf_var    = mcf_register(&bufmenu->save_mcf,    "save_config_with_data",     MCF_BOOL | MCF_W | MCF_DEFAULT, 0);
 	int save_scr_var    = mcf_register(&bufmenu->save_scr,    "save_screenshot_with_data", MCF_BOOL | MCF_W | MCF_DEFAULT, 0);
+	int ram_budget_var  = mcf_register(&bufmenu->ram_budget,  "buffer_ram_budget_MB",      MCF_DOUBLE | MCF_W | MCF_DEFAULT, M2_BUFFER_RAM_BUDGET_MB);
+	int scratch_var     = mcf_register(&bufmenu->scratch_dir, "buffer_scratch_dir",        MCF_STRING | MCF_W | MCF_DEFAULT, M2_BUFFER_SCRATCH_DIR);
 
 	mcf_connect(link_tzero_var,  "setup, panel", BLOB_CALLBACK(check_item_mcf), 0x10, bufmenu->link_tzero_item);
 	mcf_connect(save_header_var, "setup, panel", BLOB_CALLBACK(check_item_mcf), 0x10, bufmenu->save_header_item);
 	mcf_connect(save_mcf_var,    "setup, panel", BLOB_CALLBACK(check_item_mcf), 0x10, bufmenu->save_mcf_item);
 	mcf_connect(save_scr_var,    "setup, panel", BLOB_CALLBACK(check_item_mcf), 0x10, bufmenu->save_scr_item);
+	mcf_connect(ram_budget_var,  "setup",        BLOB_CALLBACK(spill_mcf),      0x10, bufmenu);
+	mcf_connect(scratch_var,     "setup",        BLOB_CALLBACK(spill_mcf),      0x10, bufmenu);
 
 	snazzy_connect(bufmenu->link_tzero_item,  "button-release-event", SNAZZY_BOOL_PTR, BLOB_CALLBACK(check_item_cb), 0x10, &bufmenu->link_tzero);
 	snazzy_connect(bufmenu->save_header_item, "button-release-event", SNAZZY_BOOL_PTR, BLOB_CALLBACK(check_item_cb), 0x10, &bufmenu->save_header);
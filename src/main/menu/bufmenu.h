@@ -32,6 +32,8 @@ typedef struct
 
 		bool link_tzero;                       // read by clear_cb()
 		bool save_header, save_mcf, save_scr;  // read by save_buffer()
+		double ram_budget;                     // MB, passed on to vs_spill_config()
+		char *scratch_dir;                     // passed on to vs_spill_config()
 
 } Bufmenu;
 
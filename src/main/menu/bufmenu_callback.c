@@ -17,6 +17,7 @@
 
 static gboolean check_item_cb (GtkWidget *widget, GdkEvent *event, bool *var);
 static void check_item_mcf (bool *var, const char *signal_name, MValue value, GtkWidget *widget);
+static void spill_mcf (void *ptr, const char *signal_name, MValue value, Bufmenu *bufmenu);
 
 gboolean check_item_cb (GtkWidget *widget, GdkEvent *event, bool *var)
 {
@@ -35,3 +36,14 @@ void check_item_mcf (bool *var, const char *signal_name, MValue value, GtkWidget
 	*var = value.x_bool;
 	gtk_check_menu_item_set_active(GTK_CHECK_MENU_ITEM(widget), value.x_bool);
 }
+
+void spill_mcf (void *ptr, const char *signal_name, MValue value, Bufmenu *bufmenu)
+{
+	f_start(F_MCF);
+
+	if (ptr == &bufmenu->scratch_dir) { replace(bufmenu->scratch_dir, cat1(value.string)); }
+	else bufmenu->ram_budget = value.x_double;
+
+	double budget = min_double(bufmenu->ram_budget * 1024 * 1024, 4.0e18);  // clamped so the conversion to int64_t is defined
+	vs_spill_config(bufmenu->scratch_dir, bufmenu->ram_budget < 0 ? -1 : (int64_t) budget);
+}
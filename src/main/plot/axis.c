@@ -105,14 +105,17 @@ bool zoom_axis (Axis *axis, SVSP svs, int mode)
 		double min_value = 0, max_value = 0;  // initialize to quiet a compiler warning
 		bool first = 1;
 
-		for (int i = 0; i < svs->N_set; i++) for (int j = 0; j < svs->data[i]->N_pt; j++)
+		for (int i = 0, N_set = svs_published(svs); i < N_set; i++)
 		{
-			double value = vs_value(svs->data[i], j, axis->vci);
-
-			min_value = first ? value : min_double(value, min_value);
-			max_value = first ? value : max_double(value, max_value);
+			VSP vs = svs_vset(svs, i);
+			double lo, hi;
+			if (vs_range(vs, 0, vs_published(vs), axis->vci, &lo, &hi) > 0)
+			{
+				min_value = first ? lo : min_double(lo, min_value);
+				max_value = first ? hi : max_double(hi, max_value);
 
-			first = 0;
+				first = 0;
+			}
 		}
 
 		update_tick(axis, max_value - min_value);
@@ -329,7 +329,7 @@ void plot_tick (Plot *plot, long draw_request)  // bite-size plotting session fo
 	cairo_t *cr = cairo_create(plot->surface);
 
 	draw_request -= plot_data(cr, plot, draw_request);
-	while (draw_request > 0 && plot->active_set + 1 < plot->svs->N_set)  // move to next set until request is satisfied or we run out of sets
+	while (draw_request > 0 && plot->active_set + 1 < svs_published(plot->svs))  // move to next set until request is satisfied or we run out of sets
 	{
 		plot->active_set++;
 		plot->draw_set = 0;
@@ -343,10 +343,10 @@ void plot_tick (Plot *plot, long draw_request)  // bite-size plotting session fo
 
 long plot_data (cairo_t *cr, Plot *plot, long draw_request)
 {
-	VSP vs = plot->svs->data[plot->active_set];
+	VSP vs = svs_vset(plot->svs, plot->active_set);  // no locking needed, see varset.h
 
 	long begin = plot->draw_set;
-	plot->draw_set = min_long(begin + draw_request, vs->N_pt);  // update plot.draw_set to reflect last plotted point
+	plot->draw_set = min_long(begin + draw_request, vs_published(vs));  // update plot.draw_set to reflect last plotted point
 	plot->draw_total += plot->draw_set - begin;
 
 	for (int a = 1; a < 3; a++)
@@ -56,37 +56,42 @@ void draw_axis_lines (cairo_t *cr, Axis *x_axis, Axis *y_axis, VSP vs, Region r,
 		set_source_rgb(cr, y_axis->lines.color);
 		cairo_new_path(cr);
 
-		for (long j = max_long(begin - 1, 0); j < end; j++)
+		const double *xp, *yp;
+		int xs, ys;
+		for (long j = max_long(begin - 1, 0), n; (n = vs_walk(vs, j, end, x_axis->vci, &xp, &xs)) > 0 && vs_walk(vs, j, end, y_axis->vci, &yp, &ys) > 0; j += n)
 		{
-			double x = scale_point(vs_value(vs, j, x_axis->vci), x_axis, r.X0, r.X1);
-			double y = scale_point(vs_value(vs, j, y_axis->vci), y_axis, r.Y1, r.Y0);
-
-			if (detect_region(x, y, r) == REGION_INSIDE)
+			for (long k = 0; k < n; k++)  // points within one block
 			{
-				if (fabs(x - x0) > M2_PLOT_LINE_MIN_DISPLACEMENT ||
-				    fabs(y - y0) > M2_PLOT_LINE_MIN_DISPLACEMENT)
-				{
-					x0 = x;
-					y0 = y;
+				double x = scale_point(xp[k * xs], x_axis, r.X0, r.X1);
+				double y = scale_point(yp[k * ys], y_axis, r.Y1, r.Y0);
 
-					if (started)
-					{
-						cairo_line_to(cr, x, y);
-						unstroked++;
-					}
-					else
+				if (detect_region(x, y, r) == REGION_INSIDE)
+				{
+					if (fabs(x - x0) > M2_PLOT_LINE_MIN_DISPLACEMENT ||
+					    fabs(y - y0) > M2_PLOT_LINE_MIN_DISPLACEMENT)
 					{
-						cairo_move_to(cr, x, y);
-						started = 1;
+						x0 = x;
+						y0 = y;
+
+						if (started)
+						{
+							cairo_line_to(cr, x, y);
+							unstroked++;
+						}
+						else
+						{
+							cairo_move_to(cr, x, y);
+							started = 1;
+						}
 					}
 				}
-			}
-			else started = 0;
+				else started = 0;
 
-			if (unstroked > M2_MAX_CAIRO_PTS)
-			{
-				cairo_stroke(cr);
-				unstroked = 0;
+				if (unstroked > M2_MAX_CAIRO_PTS)
+				{
+					cairo_stroke(cr);
+					unstroked = 0;
+				}
 			}
 		}
 	}
@@ -104,28 +109,33 @@ void draw_axis_points (cairo_t *cr, Axis *x_axis, Axis *y_axis, VSP vs, Region r
 	{
 		set_source_rgb(cr, y_axis->points.color);
 
-		for (long j = begin; j < end; j++)
+		const double *xp, *yp;
+		int xs, ys;
+		for (long j = begin, n; (n = vs_walk(vs, j, end, x_axis->vci, &xp, &xs)) > 0 && vs_walk(vs, j, end, y_axis->vci, &yp, &ys) > 0; j += n)
 		{
-			double x = scale_point(vs_value(vs, j, x_axis->vci), x_axis, r.X0, r.X1);
-			double y = scale_point(vs_value(vs, j, y_axis->vci), y_axis, r.Y1, r.Y0);
-
-			if (detect_region(x, y, r) == REGION_INSIDE)
+			for (long k = 0; k < n; k++)  // points within one block
 			{
-				if (fabs(x - x0) > M2_PLOT_POINT_MIN_DISPLACEMENT ||
-				    fabs(y - y0) > M2_PLOT_POINT_MIN_DISPLACEMENT)
+				double x = scale_point(xp[k * xs], x_axis, r.X0, r.X1);
+				double y = scale_point(yp[k * ys], y_axis, r.Y1, r.Y0);
+
+				if (detect_region(x, y, r) == REGION_INSIDE)
 				{
-					x0 = x;
-					y0 = y;
+					if (fabs(x - x0) > M2_PLOT_POINT_MIN_DISPLACEMENT ||
+					    fabs(y - y0) > M2_PLOT_POINT_MIN_DISPLACEMENT)
+					{
+						x0 = x;
+						y0 = y;
 
-					cairo_rectangle(cr, x - M2_PLOT_POINT_HALFWIDTH, y - M2_PLOT_POINT_HALFWIDTH, M2_PLOT_POINT_WIDTH, M2_PLOT_POINT_WIDTH);
-					unstroked++;
+						cairo_rectangle(cr, x - M2_PLOT_POINT_HALFWIDTH, y - M2_PLOT_POINT_HALFWIDTH, M2_PLOT_POINT_WIDTH, M2_PLOT_POINT_WIDTH);
+						unstroked++;
+					}
 				}
-			}
 
-			if (unstroked > M2_MAX_CAIRO_PTS)
-			{
-				cairo_stroke(cr);
-				unstroked = 0;
+				if (unstroked > M2_MAX_CAIRO_PTS)
+				{
+					cairo_stroke(cr);
+					unstroked = 0;
+				}
 			}
 		}
 	}
@@ -58,6 +58,10 @@ void build_chanset (ChanSet *chanset, Channel *channel_array)
 	chanset->N_gpib = 0;
 	array_set(chanset->scope_ai_count, M2_DAQ_MAX_BRD, M2_DAQ_MAX_CHAN, 0);
 
+	// identify the instruments all at once, instead of one at a time as each channel is parsed:
+	for (int vc = 0; vc < M2_MAX_CHAN; vc++) compute_discover_expr(channel_array[vc].expr);
+	gpib_device_identify();
+
 	int vci = 0, ici = 0;
 	for (int vc = 0; vc < M2_MAX_CHAN; vc++)
 	{
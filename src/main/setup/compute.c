@@ -46,8 +46,11 @@ static double compute_wait;
 
 static int compute_mode;
 static bool compute_known;
+static double compute_gpib_age;  // oldest GPIB value read so far in the current evaluation
+static long compute_gpib_seq;    // sum of the sequence numbers of those values
 static ComputeFunc *compute_cf;
 static double compute_x;
+static bool compute_discover;    // set by compute_discover_expr()
 
 static struct ComputeContext compute_context;
 static struct ComputeContext compute_context_backup;
@@ -65,6 +68,9 @@ static PyMethodDef compute_methods[] =
 	{"DAC",             DAC_cfunc,             METH_VARARGS, "Returns the specified DAC channel's value in Volts."},
 	{"gpib_slot_add",   gpib_slot_add_cfunc,   METH_VARARGS, "Registers a gpib slot."},
 	{"gpib_slot_read",  gpib_slot_read_cfunc,  METH_VARARGS, "Reads a gpib slot."},
+	{"gpib_slot_age",   gpib_slot_age_cfunc,   METH_VARARGS, "Returns the age of a gpib slot's value in seconds."},
+	{"gpib_age",        gpib_age_cfunc,        METH_VARARGS, "Returns the age of the oldest gpib value read so far in seconds."},
+	{"fresh_only",      fresh_only_cfunc,      METH_VARARGS, "Marks the channel to be recorded only when its gpib values are new."},
 	{"send_recv_local", send_recv_local_cfunc, METH_VARARGS, "Sends a local server command and receives the reply."},
 	{"wait",            wait_cfunc,            METH_VARARGS, "Tells a trigger to wait for the specifed interval in seconds."},
 	{NULL,              NULL,                  0,            NULL}
@@ -132,6 +138,8 @@ void compute_func_init (ComputeFunc *cf)
 
 	cf->py_f = NULL;
 	cf->info = NULL;
+	cf->fresh_only = 0;
+	cf->gpib_seq = 0;
 
 	cf->sub_cf = NULL;
 	cf->sub_py_f = NULL;
@@ -161,7 +169,7 @@ PyObject * lambda (const char *expr, bool use_x)
 
 	if (py_f == NULL)
 	{
-		status_add(0, supercat("Warning: \'%s\' is not a valid Python expression.\n", expr));
+		if (!compute_discover) status_add(0, supercat("Warning: \'%s\' is not a valid Python expression.\n", expr));  // say it once
 		PyErr_Clear();
 	}
 
@@ -175,10 +183,14 @@ void compute_read_expr (ComputeFunc *cf, const char *expr, double prefactor)
 	Py_XDECREF(cf->py_f);
 	cf->py_f = NULL;
 	replace(cf->info, cat1(""));
+	gpib_slot_release(cf);  // the new expression holds whatever slots and ADC channels it reads
+	daq_AI_release(cf);
 
 	// reset parsing info:
 	cf->parse_other = 0;
 	cf->parse_exec = 0;
+	cf->fresh_only = 0;
+	cf->gpib_seq = 0;
 	array_set(cf->parse_pad, M2_GPIB_MAX_BRD, M2_GPIB_MAX_PAD, 0);
 	array_set(cf->parse_dac, M2_DAQ_MAX_BRD,  M2_DAQ_MAX_CHAN, 0);
 	array_set(cf->parse_adc, M2_DAQ_MAX_BRD,  M2_DAQ_MAX_CHAN, 0);
@@ -234,6 +246,22 @@ void compute_read_expr (ComputeFunc *cf, const char *expr, double prefactor)
 		}
 }
 
+void compute_discover_expr (const char *expr)
+{
+	// Dry run of compute_read_expr(): no slots are added, but the GPIB devices in the expression
+	// are queued for gpib_device_identify(), so that the real parse finds them in the cache.
+
+	ComputeFunc cf;
+	compute_func_init(&cf);
+
+	compute_discover = 1;
+	compute_read_expr(&cf, expr, 1.0);
+	compute_discover = 0;
+
+	Py_XDECREF(cf.py_f);
+	replace(cf.info, NULL);
+}
+
 void compute_sub_define (ComputeFunc *cf, ComputeFunc *sub_cf, const char *expr)
 {
 	Py_XDECREF(cf->sub_py_f);
@@ -263,6 +291,16 @@ bool compute_function_write (ComputeFunc *cf, double value)
 	return rv;
 }
 
+bool compute_function_committed (ComputeFunc *cf)
+{
+	// a failed commit marks its channels unknown, and GPIB writes are never batched
+
+	double voltage;
+	bool rv = (cf->invertible != COMPUTE_INVERTIBLE_DAC || daq_AO_read(cf->inv_id, cf->inv_chan_slot, &voltage) == 1);
+
+	return (rv && cf->sub_cf != NULL) ? compute_function_committed(cf->sub_cf) : rv;
+}
+
 bool compute_function_read (ComputeFunc *cf, int mode, double *value)
 {
 	// Note: compute_function_read takes about 0.6 us for a simple expression on a 2 GHz core2 machine (using old Guile system)
@@ -270,12 +308,16 @@ bool compute_function_read (ComputeFunc *cf, int mode, double *value)
 	if (cf->py_f != NULL)
 	{
 		compute_mode = mode;
+		compute_cf = cf;
 		compute_known = 1;
+		compute_gpib_age = 0;
+		compute_gpib_seq = 0;
 		PyObject *py_rv _pyfree_ = PyObject_CallObject(cf->py_f, NULL);
 
 		if (py_rv != NULL)
 		{
 			*value = PyFloat_AsDouble(py_rv) / cf->prefactor;
+			cf->gpib_seq = compute_gpib_seq;
 			return compute_known;
 		}
 	}
@@ -289,7 +331,10 @@ bool compute_function_test (ComputeFunc *cf, int mode, bool *value)
 	if (cf->py_f != NULL)
 	{
 		compute_mode = mode;
+		compute_cf = cf;
 		compute_known = 1;
+		compute_gpib_age = 0;
+		compute_gpib_seq = 0;
 		PyObject *py_rv _pyfree_ = PyObject_CallObject(cf->py_f, NULL);
 
 		if (py_rv != NULL)
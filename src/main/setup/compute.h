@@ -62,6 +62,8 @@ typedef struct
 
 		int invertible;
 		bool scannable, parse_exec;
+		bool fresh_only;  // expression asked to be recorded only when its GPIB values are new
+		long gpib_seq;    // sum of the GPIB sequence numbers seen by the last read, changes whenever any value is new
 		char *info;
 
 		int parse_dac [M2_DAQ_MAX_BRD][M2_DAQ_MAX_CHAN];
@@ -91,10 +93,12 @@ double compute_get_wait  (void);
 
 void   compute_func_init      (ComputeFunc *cf);
 void   compute_read_expr      (ComputeFunc *cf, const char *expr, double prefactor);
+void   compute_discover_expr  (const char *expr);  // follow with gpib_device_identify()
 void   compute_sub_define     (ComputeFunc *cf, ComputeFunc *sub_cf, const char *expr);
 bool   compute_function_read  (ComputeFunc *cf, int mode, double *value);
 bool   compute_function_test  (ComputeFunc *cf, int mode, bool *value);
 bool   compute_function_write (ComputeFunc *cf, double value);
+bool   compute_function_committed (ComputeFunc *cf);  // after daq_AO_batch_commit(), whether the DAC(s) behind a batched write were actually written
 double compute_linear_compute (ComputeFunc *cf, int dir, double input);
 
 #endif
@@ -25,13 +25,21 @@ class GPIB_Device :
 		self.intro = '*IDN?'
 		self.noninverse_fn = 0
 		self.inverse_fn = 0
+		self.priority = 0
+		self.coalesce = None  # optional (prefix, item, separator): share one compound query with other quantities on the same instrument
+		self.convert = None   # optional (parser, scale, offset): parse and scale in C instead of reply_fmt and noninverse_fn/inverse_fn (see gpib.h)
+		self.write_interval = None  # optional minimum seconds between setpoint writes during sweeps (None: 0.1 s)
 		self.slotid = [[-2 for i in range(32)] for i in range(8)]
 
 	def __call__ (self, brd, pad) :
 		if self.slotid[brd][pad] == -2 :
-			self.slotid[brd][pad] = gpib_slot_add(brd, pad, self.eos, self.intro, self.cmd, self.period, self.dummy_value, self.reply_fmt, self.write_fmt, self.noninverse_fn, self.inverse_fn)
+			self.slotid[brd][pad] = gpib_slot_add(brd, pad, self.eos, self.intro, self.cmd, self.period, self.dummy_value, self.reply_fmt, self.write_fmt, self.noninverse_fn, self.inverse_fn, self.priority, self.coalesce, self.convert, self.write_interval)
 		return gpib_slot_read(brd, self.slotid[brd][pad])
 
+	def age (self, brd, pad) :  # seconds since the value returned by __call__ was measured
+		self.__call__(brd, pad)
+		return gpib_slot_age(brd, self.slotid[brd][pad])
+
 	def reset (self) :
 		self.slotid = [[-2 for i in range(32)] for i in range(8)]
 
@@ -48,6 +56,8 @@ def nearest_index (l, x) :  # Use to 'invert' lookup tables. List 'l' must be pr
 #def ch    (chan)         : <built-in function>
 #def DAC   (dev_id, chan) : <built-in function>
 #def ADC   (dev_id, chan) : <built-in function>
+#def gpib_age ()          : <built-in function>  # age in seconds of the oldest GPIB value read so far by this expression
+#def fresh_only (x)       : <built-in function>  # returns x, and records this channel's rows only when its GPIB values are new
 
 def DAC0 () : return DAC(0, 0)
 def DAC1 () : return DAC(0, 1)
@@ -80,8 +90,13 @@ def divide (N, D, level) : return (N / D if (abs(D) > level) else 0.0)
 A8648_Freq    = GPIB_Device('FREQ:CW?',  0.5, 1e6,   '%lf',  'FREQ:CW %1.8e HZ')   # Agilent 8648 source: current frequency on Agilent 8648 source
 A8648_Ampl    = GPIB_Device('POW:AMPL?', 0.5, -10,   '%lf',  'POW:AMPL %1.6f DB')  # Agilent 8648 source: current amplitude, read in dBmW (the only option), written in dBmW
 A8648_Ampl_V  = GPIB_Device('POW:AMPL?', 0.5, -10,   '%lf',  'POW:AMPL %1.6f DB')  # Agilent 8648 source: current amplitude, read in dBmW (the only option), written in dBmW
+A8648_FreqMHz = GPIB_Device('FREQ:CW?',  0.5, 1e6,   '%lf',  'FREQ:CW %1.8e HZ')   # Agilent 8648 source: current frequency in MHz
 SR830_SineOut = GPIB_Device('SLVL?',     0.5, 50e-3, '%lf',  'SLVL%f')             # SRS SR830 lock-in:   SINE output level
 SR830_SensIn  = GPIB_Device('SENS?',     1.0, 17,    '%lf',  'SENS%0.0f')          # SRS SR830 lock-in:   input sensitivity
+SR830_X       = GPIB_Device('OUTP?1',    0.5, 0.0,   '%lf',  '')                   # SRS SR830 lock-in:   X output in V
+SR830_Y       = GPIB_Device('OUTP?2',    0.5, 0.0,   '%lf',  '')                   # SRS SR830 lock-in:   Y output in V
+SR830_R       = GPIB_Device('OUTP?3',    0.5, 0.0,   '%lf',  '')                   # SRS SR830 lock-in:   R output in V
+SR830_Theta   = GPIB_Device('OUTP?4',    0.5, 0.0,   '%lf',  '')                   # SRS SR830 lock-in:   theta output in degrees
 ITC503_Temp   = GPIB_Device('R1\r',      1.0, 300,   'R%lf', '')                   # Oxford ITC503:       current temperature on sensor 1 in Kelvin
 IPS120_Field  = GPIB_Device('R8\r',      1.0, 0.0,   'R%lf', '')                   # Oxford IPS120:       set field in Tesla
 
@@ -93,8 +108,16 @@ sens_table = [2e-9, 5e-9, 1e-8, 2e-8, 5e-8, 1e-7, 2e-7, 5e-7, 1e-6, 2e-6, 5e-6,
 SR830_SensIn.noninverse_fn = lambda x : sens_table[int(x)]
 SR830_SensIn.inverse_fn    = lambda x : nearest_index(sens_table, x)
 
+A8648_FreqMHz.convert = ('', 1e-6, 0.0)  # Hz to MHz, both ways
+
+SR830_X.coalesce     = ('SNAP?', '1', ',')  # read together as e.g. 'SNAP?1,2,3'
+SR830_Y.coalesce     = ('SNAP?', '2', ',')
+SR830_R.coalesce     = ('SNAP?', '3', ',')
+SR830_Theta.coalesce = ('SNAP?', '4', ',')
+
 ITC503_Temp.eos   = IPS120_Field.eos   = 0x400 | 0xd
 ITC503_Temp.intro = IPS120_Field.intro = 'V\r'
+ITC503_Temp.convert = IPS120_Field.convert = ('number:0', 1.0, 0.0)  # tolerates a missing or different leading letter
 
 ##############  Trigger Instruction Functions ###############
 
@@ -22,6 +22,9 @@ static PyObject * ADC_cfunc (PyObject *py_self, PyObject *py_args);
 static PyObject * DAC_cfunc (PyObject *py_self, PyObject *py_args);
 static PyObject * gpib_slot_add_cfunc (PyObject *py_self, PyObject *py_args);
 static PyObject * gpib_slot_read_cfunc (PyObject *py_self, PyObject *py_args);
+static PyObject * gpib_slot_age_cfunc (PyObject *py_self, PyObject *py_args);
+static PyObject * gpib_age_cfunc (PyObject *py_self, PyObject *py_args);
+static PyObject * fresh_only_cfunc (PyObject *py_self, PyObject *py_args);
 static PyObject * send_recv_local_cfunc (PyObject *py_self, PyObject *py_args);
 static PyObject * wait_cfunc (PyObject *py_self, PyObject *py_args);
 
@@ -67,8 +70,8 @@ PyObject * ADC_cfunc (PyObject *py_self, PyObject *py_args)
 
 	double x = 0;
 
-	if       (compute_mode & COMPUTE_MODE_POINT) { if (daq_AI_read(id, chan, &x) != 1) compute_known = 0; }
-	else if  (compute_mode & COMPUTE_MODE_SCAN)  { daq_AI_convert(id, chan, compute_point, &x); }
+	if       (compute_mode & COMPUTE_MODE_POINT) { daq_AI_hold(id, chan, compute_cf); if (daq_AI_read(id, chan, &x) != 1) compute_known = 0; }
+	else if  (compute_mode & COMPUTE_MODE_SCAN)  { daq_AI_resample(id, chan, compute_time, &x); }
 	else if ((compute_mode & COMPUTE_MODE_PARSE) && daq_AI_valid(id, chan))
 	{
 		compute_cf->parse_adc[id][chan]++;
@@ -86,7 +89,7 @@ PyObject * DAC_cfunc (PyObject *py_self, PyObject *py_args)
 	double x = 0;
 
 	if      (compute_mode & COMPUTE_MODE_POINT) { if (daq_AO_read(id, chan, &x) != 1) compute_known = 0; }
-	else if (compute_mode & COMPUTE_MODE_SCAN)  { daq_AO_convert(id, chan, compute_point, &x); }
+	else if (compute_mode & COMPUTE_MODE_SCAN)  { daq_AO_resample(id, chan, compute_time, &x); }
 	else if (compute_mode & COMPUTE_MODE_SOLVE)
 	{
 		if (daq_AO_valid(id, chan)) x = compute_x;
@@ -118,12 +121,34 @@ PyObject * gpib_slot_add_cfunc (PyObject *py_self, PyObject *py_args)
 	char     *write_fmt   = PyString_AsString   (PyTuple_GetItem(py_args, 8));
 	PyObject *py_noninv_f =                      PyTuple_GetItem(py_args, 9);
 	PyObject *py_inv_f    =                      PyTuple_GetItem(py_args, 10);
+	int      priority     = (int) PyLong_AsLong (PyTuple_GetItem(py_args, 11));
+	PyObject *py_coalesce =                      PyTuple_GetItem(py_args, 12);
+	PyObject *py_convert  =                      PyTuple_GetItem(py_args, 13);
+	PyObject *py_write_dt =                      PyTuple_GetItem(py_args, 14);
+
+	if (compute_discover)  // see compute_discover_expr(), the slot is added by the real parse
+	{
+		char *idn _strfree_ = (str_length(intro) > 0 && str_length(write_fmt) > 0 && gpib_board_connected(id)) ? gpib_device_idn(id, pad, intro) : NULL;
+		return PyLong_FromLong(-2);
+	}
 
 	if (!PyCallable_Check(py_noninv_f)) py_noninv_f = NULL;
 	if (!PyCallable_Check(py_inv_f))    py_inv_f    = NULL;
 
 	if (eos != 0) gpib_device_set_eos(id, pad, eos);
-	int s = gpib_slot_add(id, pad, cmd, period, dummy_value, reply_fmt, write_fmt, py_noninv_f, py_inv_f);
+	int s = gpib_slot_add(id, pad, cmd, period, priority, dummy_value, reply_fmt, write_fmt, py_noninv_f, py_inv_f);
+
+	if (s >= 0 && PyTuple_Check(py_coalesce) && PyTuple_Size(py_coalesce) == 3)
+		gpib_slot_coalesce(id, s, PyString_AsString(PyTuple_GetItem(py_coalesce, 0)),
+		                          PyString_AsString(PyTuple_GetItem(py_coalesce, 1)),
+		                          PyString_AsString(PyTuple_GetItem(py_coalesce, 2)));
+
+	if (s >= 0 && PyTuple_Check(py_convert) && PyTuple_Size(py_convert) == 3)  // native conversion, so that reading the slot needs no Python calls
+		gpib_slot_convert(id, s, PyString_AsString(PyTuple_GetItem(py_convert, 0)),
+		                         PyFloat_AsDouble (PyTuple_GetItem(py_convert, 1)),
+		                         PyFloat_AsDouble (PyTuple_GetItem(py_convert, 2)));
+
+	if (s >= 0 && py_write_dt != Py_None) gpib_slot_throttle(id, s, PyFloat_AsDouble(py_write_dt));
 
 	if ((compute_mode & COMPUTE_MODE_PARSE) && (s >= 0) && (str_length(write_fmt) > 0))
 	{
@@ -131,8 +156,8 @@ PyObject * gpib_slot_add_cfunc (PyObject *py_self, PyObject *py_args)
 		compute_cf->inv_id = id;
 		compute_cf->inv_chan_slot = s;
 
-		char *idn = (str_length(intro) > 0) ? gpib_string_query(id, pad, intro, str_length(intro), 1) : NULL;
-		char *str_idn = atg(idn != NULL ? supercat("%s / ", atg(str_strip_end(idn, "\n\r"))) : cat1(""));
+		char *idn _strfree_ = (str_length(intro) > 0) ? gpib_device_idn(id, pad, intro) : NULL;  // cached, or left out until the next gpib_device_identify()
+		char *str_idn = atg(str_length(idn) > 0 ? supercat("%s / ", idn) : cat1(""));
 
 		replace(compute_cf->info, supercat("%s\n   GPIB %d, PAD %d: %s%s", compute_cf->info, id, pad, str_idn, atg(str_strip_end(cmd, "?"))));
 	}
@@ -147,8 +172,47 @@ PyObject * gpib_slot_read_cfunc (PyObject *py_self, PyObject *py_args)
 
 	double x = 0;
 
-	if      (compute_mode & (COMPUTE_MODE_POINT | COMPUTE_MODE_SCAN)) { if (gpib_slot_read(id, s, &x) == 0) compute_known = 0; }
-	else if (compute_mode & COMPUTE_MODE_SOLVE)                       { x = compute_x;                                         }
+	if (compute_mode & (COMPUTE_MODE_PARSE | COMPUTE_MODE_POINT | COMPUTE_MODE_SCAN)) gpib_slot_hold(id, s, compute_cf);  // keeps the slot polled
+
+	if (compute_mode & (COMPUTE_MODE_POINT | COMPUTE_MODE_SCAN))
+	{
+		if (gpib_slot_read(id, s, &x) == 0) compute_known = 0;
+
+		double age;
+		long seq;
+		if (gpib_slot_age(id, s, &age, &seq) == 1)
+		{
+			compute_gpib_age = max_double(compute_gpib_age, age);
+			compute_gpib_seq += seq;
+		}
+	}
+	else if (compute_mode & COMPUTE_MODE_SOLVE) x = compute_x;
+
+	return PyFloat_FromDouble(x);
+}
+
+PyObject * gpib_slot_age_cfunc (PyObject *py_self, PyObject *py_args)
+{
+	int id = -1, s = -1;
+	PyArg_ParseTuple(py_args, "ii", &id, &s);
+
+	double age = 0;
+	long seq;
+	if ((compute_mode & (COMPUTE_MODE_POINT | COMPUTE_MODE_SCAN)) && gpib_slot_age(id, s, &age, &seq) == 0) compute_known = 0;
+
+	return PyFloat_FromDouble(age);
+}
+
+PyObject * gpib_age_cfunc (PyObject *py_self, PyObject *py_args)
+{
+	return PyFloat_FromDouble(compute_gpib_age);
+}
+
+PyObject * fresh_only_cfunc (PyObject *py_self, PyObject *py_args)
+{
+	double x = PyFloat_AsDouble(PyTuple_GetItem(py_args, 0));
+
+	if (compute_mode & COMPUTE_MODE_PARSE) compute_cf->fresh_only = 1;
 
 	return PyFloat_FromDouble(x);
 }
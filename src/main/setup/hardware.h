@@ -28,6 +28,7 @@ typedef struct  // Note: All members are accessed by only the GUI thread.
 		int id;            // board id to use with *_board_connect()
 		bool real, dummy;  // real is set once at init, dummy can change in callbacks
 		int settle;        // DAQ-only
+		int background;    // DAQ-only, scans averaged for background point-mode sampling (0 = off)
 		char *node[4];
 
 		Section sect;
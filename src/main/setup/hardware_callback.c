@@ -22,6 +22,7 @@ static void revis_cb (GtkWidget *widget, Hardware *hw);
 static void hardware_node_mcf (void *ptr, const char *signal_name, MValue value, Hardware *hw, int d);
 static void hardware_dummy_mcf (void *ptr, const char *signal_name, MValue value, Hardware *hw);
 static void hardware_settle_mcf (void *ptr, const char *signal_name, MValue value, Hardware *hw);
+static void hardware_background_mcf (void *ptr, const char *signal_name, MValue value, Hardware *hw);
 
 gboolean hardware_node_cb (GtkWidget *widget, GdkEvent *event, Hardware *hw)
 {
@@ -81,6 +82,15 @@ void hardware_settle_mcf (void *ptr, const char *signal_name, MValue value, Hard
 	hardware_update(hw);
 }
 
+void hardware_background_mcf (void *ptr, const char *signal_name, MValue value, Hardware *hw)
+{
+	f_start(F_MCF);
+
+	hw->background = value.x_int;
+
+	hardware_update(hw);
+}
+
 void revis_cb (GtkWidget *widget, Hardware *hw)
 {
 	f_start(F_CALLBACK);
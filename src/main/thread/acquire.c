@@ -33,6 +33,9 @@ struct Clk
 	Timer *bo_timer;
 	bool bo_enabled;
 
+	double t0_step;        // set by run_sweep_step() while DAC writes are batched,
+	bool jumped, jump_ok;  // and settled by finish_sweep_step() once they are committed
+
 };
 
 struct CircleBuffer
@@ -45,12 +48,18 @@ struct CircleBuffer
 struct ScanVars
 {
 	int  counter      [M2_NUM_DAQ];
-	int  read_mult    [M2_NUM_DAQ];
 	long s_read_total [M2_NUM_DAQ];
 	int  prog_mult;
 
 };
 
+struct GpibWorker
+{
+	ThreadVars *tv;
+	int id;  // each connected board gets its own thread, so a slow bus does not hold up the others
+
+};
+
 struct SweepEvent
 {
 	bool any, zerostop, min, max, min_posthold, max_posthold;
@@ -58,6 +67,7 @@ struct SweepEvent
 };
 
 static void * run_gpib_thread (void *data);
+static bool take_gpib_request (ThreadVars *tv, int id, struct GpibRequest *req);
 
 static bool run_acquisition    (ThreadVars *tv, struct CircleBuffer *cbuf);
 static void run_recording      (ThreadVars *tv, struct CircleBuffer *cbuf, struct Clk *clk, bool *binsize_valid, double *binsize, Buffer *buffer);
@@ -65,6 +75,7 @@ static void run_triggers       (Panel *panel);
 static bool run_scope_start    (ThreadVars *tv, struct ScanVars *sv, Scope *scope, double loop_interval);
 static bool run_scope_continue (ThreadVars *tv, struct ScanVars *sv, Scope *scope, Buffer *buffer);
 static void run_sweep_step     (Sweep *sweep, double t, struct Clk *clk, struct SweepEvent *sweep_event);
+static void finish_sweep_step  (Sweep *sweep, struct Clk *clk, bool committed);
 static void run_sweep_response (ThreadVars *tv, struct SweepEvent *sweep_event);
 
 static void init_circle_buffer (struct CircleBuffer *cbuf, int length);
@@ -91,6 +102,8 @@ void thread_init_all (ThreadVars *tv)
 	tv->catch_signal = NULL;
 
 	tv->scope_bench_timer = timer_new();
+	tv->gpib_clock = timer_new();
+	tv->N_gpib_request = 0;
 }
 
 void thread_final_all (ThreadVars *tv)
@@ -103,6 +116,7 @@ void thread_final_all (ThreadVars *tv)
 	mt_mutex_clear(&tv->ts_mutex);
 
 	timer_destroy(tv->scope_bench_timer);
+	timer_destroy(tv->gpib_clock);
 }
 
 void thread_register_daq (ThreadVars *tv)
@@ -121,62 +135,90 @@ void thread_register_daq (ThreadVars *tv)
 
 void * run_gpib_thread (void *data)
 {
-	ThreadVars *tv = data;
+	struct GpibWorker *worker = data;
+	ThreadVars *tv = worker->tv;
+	int id = worker->id;
 	Timer *timer _timerfree_ = timer_new();
 
-	int sr_id, sr_pad, sr_eos;  // ignore "used uninitialized" warnings
-	bool sr_expect_reply;
-	char *sr_msg = NULL;
-
 	mt_mutex_lock(&tv->gpib_mutex);
 
 	do
 	{
-		if (tv->gpib_msg != NULL)
-		{
-			sr_id  = tv->gpib_id;
-			sr_pad = tv->gpib_pad;
-			sr_eos = tv->gpib_eos;
+		struct GpibRequest req;
+		bool have_req = take_gpib_request(tv, id, &req);  // requests for other boards are left to their own workers
+		bool expired = have_req && timer_elapsed(tv->gpib_clock) > req.t_expire;
+		bool paused = tv->gpib_paused;
+		mt_mutex_unlock(&tv->gpib_mutex);
 
-			sr_msg = tv->gpib_msg;
-			tv->gpib_msg = NULL;
+		if (have_req)  // terminal requests go ahead of polling, and the queue is drained before polling resumes
+		{
+			char *reply _strfree_ = NULL;
+			if (expired)
+			{
+				reply = cat1("timeout");
+				if (!req.expect_reply) status_add(1, supercat("Warning: GPIB request \"%s\" timed out before board %d was free.\n", req.msg, id));
+			}
+			else
+			{
+				if (req.eos) gpib_device_set_eos(id, req.pad, req.eos);
 
-			sr_expect_reply = tv->gpib_expect_reply;
-		}
+				char *msg_out = gpib_string_query(id, req.pad, req.msg, str_length(req.msg), req.expect_reply);
+				if (req.expect_reply) reply = cat3(get_cmd(M2_TS_ID), ";msg|", msg_out);
+			}
 
-		if (!tv->gpib_paused)
-		{
-			for (int id = 0; id < M2_NUM_GPIB; id++) gpib_multi_transfer(id);
-			mt_mutex_unlock(&tv->gpib_mutex);
+			replace(req.msg, NULL);
 
-			for (int id = 0; id < M2_NUM_GPIB; id++) gpib_multi_tick(id);
+			if (req.expect_reply)
+			{
+				mt_mutex_lock(&tv->ts_mutex);
+				control_server_reply(M2_TS_ID, reply);
+				mt_mutex_unlock(&tv->ts_mutex);
+			}
 		}
-		else mt_mutex_unlock(&tv->gpib_mutex);
-
-		if (sr_msg != NULL)
+		else
 		{
-			if (sr_eos) gpib_device_set_eos(sr_id, sr_pad, sr_eos);
-
-			char *msg_out = gpib_string_query(sr_id, sr_pad, sr_msg, str_length(sr_msg), sr_expect_reply);
-			char *reply _strfree_ = sr_expect_reply ? cat3(get_cmd(M2_TS_ID), ";msg|", msg_out) : cat1(get_cmd(M2_TS_ID));
-
-			replace(sr_msg, NULL);
+			if (!paused)
+			{
+				gpib_multi_transfer(id);  // takes only this board's lock
+				gpib_multi_tick(id);      // returns early if a request comes in
+			}
 
-			mt_mutex_lock(&tv->ts_mutex);
-			control_server_reply(M2_TS_ID, reply);
-			mt_mutex_unlock(&tv->ts_mutex);
+			wait_and_reset(timer, 0.02);
 		}
 
-		wait_and_reset(timer, 0.02);
-
 		mt_mutex_lock(&tv->gpib_mutex);
 	}
 	while (tv->gpib_running);
 
+	bool paused = tv->gpib_paused;
 	mt_mutex_unlock(&tv->gpib_mutex);
+
+	if (!paused)  // the last setpoint of a sweep still goes out
+	{
+		gpib_multi_transfer(id);
+		gpib_multi_flush(id);
+	}
+
 	return data;
 }
 
+bool take_gpib_request (ThreadVars *tv, int id, struct GpibRequest *req)
+{
+	// call with gpib_mutex held; highest priority first, then oldest first
+
+	int best = -1;
+	for (int n = 0; n < tv->N_gpib_request; n++)
+		if (tv->gpib_request[n].id == id && (best == -1 || tv->gpib_request[n].priority > tv->gpib_request[best].priority)) best = n;
+
+	if (best == -1) return 0;
+
+	*req = tv->gpib_request[best];
+	for (int n = best; n < tv->N_gpib_request - 1; n++) tv->gpib_request[n] = tv->gpib_request[n + 1];
+	tv->N_gpib_request--;
+
+	return 1;
+}
+
 void * run_daq_thread (void *data)
 {
 	ThreadVars *tv = data;
@@ -234,6 +276,8 @@ void * run_daq_thread (void *data)
 		clk[ici].bo_enabled = 0;
 		clk[ici].bo_timer = timer_new();
 		clk[ici].bo_target = 0;
+		clk[ici].t0_step = 0;
+		clk[ici].jumped = clk[ici].jump_ok = 0;
 	}
 
 	// main data aquisition loops
@@ -244,10 +288,17 @@ void * run_daq_thread (void *data)
 
 	tv->gpib_running = 1;
 	tv->gpib_paused = 0;
-	tv->gpib_msg = NULL;
+	tv->N_gpib_request = 0;
 
-	MtThread gpib_thread = mt_thread_create(run_gpib_thread, tv);
-	f_print(F_UPDATE, "Created GPIB thread.\n");
+	struct GpibWorker gpib_worker [M2_NUM_GPIB];
+	MtThread          gpib_thread [M2_NUM_GPIB];
+	for (int id = 0; id < M2_NUM_GPIB; id++)
+	{
+		gpib_worker[id].tv = tv;
+		gpib_worker[id].id = id;
+		gpib_thread[id] = gpib_board_connected(id) ? mt_thread_create(run_gpib_thread, &gpib_worker[id]) : NULL;
+		if (gpib_thread[id] != NULL) f_print(F_UPDATE, "Created GPIB%d thread.\n", id);
+	}
 
 	long k_sleep = 1;
 	while (get_logger_rl(tv) != LOGGER_RL_STOP)
@@ -330,11 +381,14 @@ void * run_daq_thread (void *data)
 			mt_mutex_lock(&tv->gpib_mutex);
 
 			double t = timer_elapsed(sweep_timer);  // All sweeps share the same timebase this way.
+			daq_AO_batch_begin();  // leaders and followers move together
 			for (int ici = 0; ici < tv->chanset->N_inv_chan; ici++)
 			{
 				run_sweep_step(&tv->panel->sweep[ici], t, &clk[ici], &sweep_event[ici]);
 				if (sweep_event[ici].any) any_event = 1;
 			}
+			bool committed = daq_AO_batch_commit();
+			for (int ici = 0; ici < tv->chanset->N_inv_chan; ici++) finish_sweep_step(&tv->panel->sweep[ici], &clk[ici], committed);
 
 			for (int ici = 0; ici < tv->chanset->N_inv_chan; ici++) exec_sweep_dir(&tv->panel->sweep[ici]);  // Actually change sweep dir/hold now that everyone has had a chance to update.
 			                                                                                                 // Otherwise leader/follower relationships will get out of sync.
@@ -350,8 +404,28 @@ void * run_daq_thread (void *data)
 	mt_mutex_lock(&tv->gpib_mutex);
 	tv->gpib_running = 0;
 	mt_mutex_unlock(&tv->gpib_mutex);
-	mt_thread_join(gpib_thread);
-	f_print(F_UPDATE, "Joined GPIB thread.\n");
+	for (int id = 0; id < M2_NUM_GPIB; id++) if (gpib_thread[id] != NULL)
+	{
+		mt_thread_join(gpib_thread[id]);
+		f_print(F_UPDATE, "Joined GPIB%d thread.\n", id);
+
+		GpibBoardStats stats;
+		if (gpib_board_stats(id, &stats) && stats.N_query > 0)
+			f_print(F_BENCH, "GPIB%d: %ld queries, %ld timeouts, %ld writes, %1.0f%% busy, %1.0f%% requested\n",
+			        id, stats.N_query, stats.N_timeout, stats.N_write, 1e2 * stats.utilization, 1e2 * stats.load);
+	}
+
+	for (int n = 0; n < tv->N_gpib_request; n++)  // requests that came in too late
+	{
+		if (tv->gpib_request[n].expect_reply)
+		{
+			mt_mutex_lock(&tv->ts_mutex);
+			control_server_reply(M2_TS_ID, "timeout");
+			mt_mutex_unlock(&tv->ts_mutex);
+		}
+		replace(tv->gpib_request[n].msg, NULL);
+	}
+	tv->N_gpib_request = 0;
 
 	for (int ici = 0; ici < tv->chanset->N_inv_chan; ici++) timer_destroy(clk[ici].bo_timer);
 
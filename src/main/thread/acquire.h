@@ -28,14 +28,24 @@ enum
 	RL_NO_HOLD = 100
 };
 
+struct GpibRequest
+{
+	int id, pad, eos;
+	char *msg;
+	bool expect_reply;  // the terminal is waiting on the reply
+	int priority;       // higher goes first, then oldest first
+	double t_expire;    // on ThreadVars.gpib_clock
+};
+
 typedef struct
 {
 	// private:
 
-		bool gpib_running;                    // threads: shared by DAQ and GPIB, protected by ThreadVars.gpib_mutex
+		bool gpib_running;                    // threads: shared by DAQ and GPIB workers, protected by ThreadVars.gpib_mutex
 
 		double data_daq  [M2_MAX_CHAN];       // threads: DAQ only
 		bool   known_daq [M2_MAX_CHAN];       //
+		long   seq_recorded [M2_MAX_CHAN];    // threads: DAQ only, ComputeFunc.gpib_seq as of the last recorded point
 
 		Timer *scope_bench_timer;             // threads: shared, protected by rl_mutex
 
@@ -49,11 +59,9 @@ typedef struct
 		int logger_rl, scope_rl;              // threads: shared by DAQ and GUI,  protected by ThreadVars.rl_mutex
 
 		bool  gpib_paused;                    // threads: shared by GPIB and GUI, protected by ThreadVars.gpib_mutex
-		int   gpib_id, gpib_pad, gpib_eos;    //
-		char *gpib_msg;                       //
-		bool  gpib_expect_reply;              //
-
-		// Note: gpib_id, gpib_pad, gpib_eos, gpib_expect_reply are not set until an actual msg request occurs.
+		struct GpibRequest gpib_request [M2_GPIB_MAX_REQUEST];  //
+		int   N_gpib_request;                 //
+		Timer *gpib_clock;                    // threads: shared (read-only)
 
 		double data_shared  [M2_MAX_CHAN];    // threads: shared, protected by ThreadVars.data_mutex
 		bool   known_shared [M2_MAX_CHAN];    // threads: shared, protected by ThreadVars.data_mutex
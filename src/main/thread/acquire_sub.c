@@ -92,6 +92,19 @@ void run_recording (ThreadVars *tv, struct CircleBuffer *cbuf, struct Clk *clk,
 			else clk[ici].bo_enabled = 0;
 		}
 
+	// channels defined with fresh_only() hold recording until one of them has a new GPIB value:
+	bool gated = 0, fresh = 0;
+	for (int vci = 0; vci < tv->chanset->N_total_chan; vci++)
+	{
+		ComputeFunc *cf = &tv->chanset->channel_by_vci[vci]->cf;
+		if (cf->fresh_only)
+		{
+			gated = 1;
+			fresh |= (cf->gpib_seq != tv->seq_recorded[vci]);
+		}
+	}
+	if (gated && !fresh) record_ok = 0;
+
 	mt_mutex_lock(&buffer->mutex);
 	if (buffer->do_time_reset)
 	{
@@ -102,21 +115,20 @@ void run_recording (ThreadVars *tv, struct CircleBuffer *cbuf, struct Clk *clk,
 	else if (record_ok)  // skip data taking this cycle to avoid old time() data
 	{
 		VSP vs = active_vsp(buffer);
-		if (vs->N_pt == 0)
-		{
-			append_point(vs, tv->data_daq);
-			vs->data_saved = 0;
-		}
+		long N_pt = vs->N_pt;
+		if (vs->N_pt == 0) append_point(vs, tv->data_daq);
 		else
 		{
 			for (int vci = 0; vci < tv->chanset->N_total_chan; vci++)
 				if (binsize_valid[vci] && fabs(tv->data_daq[vci] - vs_value(vs, vs->N_pt - 1, vci)) > binsize[vci])
 				{
 					append_point(vs, tv->data_daq);
-					vs->data_saved = 0;
 					break;
 				}
 		}
+
+		if (vs->N_pt != N_pt) for (int vci = 0; vci < tv->chanset->N_total_chan; vci++)
+			tv->seq_recorded[vci] = tv->chanset->channel_by_vci[vci]->cf.gpib_seq;
 	}
 	mt_mutex_unlock(&buffer->mutex);
 }
@@ -127,7 +139,10 @@ void run_triggers (Panel *panel)
 
 	for (int n = 0; n < M2_MAX_TRIG; n++) if (panel->trigger[n].any_line_dirty) trigger_parse(&panel->trigger[n]);
 	for (int n = 0; n < M2_MAX_TRIG; n++) if (panel->trigger[n].armed)          trigger_check(&panel->trigger[n]);
+
+	daq_AO_batch_begin();  // DAC writes up to the next wait (or the end) go out together
 	for (int n = 0; n < M2_MAX_TRIG; n++) if (panel->trigger[n].busy)           trigger_exec (&panel->trigger[n]);
+	if (!daq_AO_batch_commit()) status_add(1, cat1("Warning: DAC writes from triggers did not all go out (channels marked unknown).\n"));
 
 	mt_mutex_unlock(&panel->trigger_mutex);
 }
@@ -176,7 +191,7 @@ bool run_scope_continue (ThreadVars *tv, struct ScanVars *sv, Scope *scope, Buff
 	double elapsed = daq_SCAN_elapsed(scope->master_id);
 	if (get_scope_rl(tv) == SCOPE_RL_SCAN && elapsed < scope->scan[scope->master_id].total_time)
 	{
-		scan_array_read(scope->scan, sv->counter, sv->read_mult, sv->s_read_total);  // increments counter
+		scan_array_read(scope->scan, sv->counter, sv->s_read_total);  // increments counter
 
 		if (sv->counter[scope->master_id] % sv->prog_mult == 0) set_scan_progress(buffer, elapsed / scope->scan[scope->master_id].total_time);
 
@@ -212,11 +227,9 @@ void compute_intervals (struct ScanVars *sv, Scan *scan_array, double loop_inter
 	for (int id = 0; id < M2_NUM_DAQ; id++)
 	{
 		sv->counter[id] = 0;
-		sv->read_mult[id] = floor_int(scan_array[id].read_interval / loop_interval);
 		sv->s_read_total[id] = 0;
 
-		f_print(F_BENCH, "DAQ%d: read interval: %f ms\n", id, scan_array[id].read_interval * 1e3);
-		f_print(F_BENCH, "DAQ%d: read multiple: %d\n",    id, sv->read_mult[id]);
+		f_print(F_BENCH, "DAQ%d: nominal read interval: %f ms\n", id, scan_array[id].read_interval * 1e3);
 	}
 }
 
@@ -231,8 +244,8 @@ void run_sweep_step (Sweep *sweep, double t, struct Clk *clk, struct SweepEvent
 		{
 			if (sweep->channel != NULL)
 			{
-				bool success = compute_function_write(&sweep->channel->cf, sweep->jump_scaled);
-				status_add(1, supercat("Set \"%s\" to %f: %s\n", sweep->channel->desc, sweep->jump_scaled, success ? "Success" : "Failure"));
+				clk->jump_ok = compute_function_write(&sweep->channel->cf, sweep->jump_scaled);
+				clk->jumped = 1;  // reported by finish_sweep_step()
 			}
 			sweep->jump_dirty = 0;
 		}
@@ -299,7 +312,7 @@ void run_sweep_step (Sweep *sweep, double t, struct Clk *clk, struct SweepEvent
 					{
 						int side = (sweep->dir == 1) ? UPPER : LOWER;
 						set_blackout(clk, sweep->dwell.value[side], sweep->blackout.value[side]);
-						clk->t0 += dt_adj;
+						clk->t0_step = dt_adj;  // applied by finish_sweep_step()
 					}
 				}
 			}
@@ -312,6 +325,19 @@ void run_sweep_step (Sweep *sweep, double t, struct Clk *clk, struct SweepEvent
 	}
 }
 
+void finish_sweep_step (Sweep *sweep, struct Clk *clk, bool committed)
+{
+	// run_sweep_step() writes inside a DAC batch, so its writes only count once committed
+
+	bool ok = committed || (sweep->channel != NULL && compute_function_committed(&sweep->channel->cf));
+
+	if (clk->jumped) status_add(1, supercat("Set \"%s\" to %f: %s\n", sweep->channel->desc, sweep->jump_scaled, clk->jump_ok && ok ? "Success" : "Failure"));
+	if (ok) clk->t0 += clk->t0_step;
+
+	clk->t0_step = 0;
+	clk->jumped = clk->jump_ok = 0;
+}
+
 void set_blackout (struct Clk *clk, double dwell, double blackout)
 {
 	clk->bo_enabled = 1;
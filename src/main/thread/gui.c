@@ -37,6 +37,8 @@ void thread_register_gui (ThreadVars *tv)
 	control_server_connect(M2_TS_ID, "read_channel",             all_pid(M2_CODE_GUI),                 BLOB_CALLBACK(read_channel_csf),   0x30, tv->chanset, tv->data_gui, tv->known_gui);
 	control_server_connect(M2_TS_ID, "get_sweep_id",             all_pid(M2_CODE_GUI),                 BLOB_CALLBACK(get_sweep_id_csf),   0x10, tv->chanset);
 	control_server_connect(M2_TS_ID, "gpib_send_recv",           all_pid(M2_CODE_GUI) | M2_CODE_SETUP, BLOB_CALLBACK(gpib_send_recv_csf), 0x10, tv);
+	control_server_connect(M2_TS_ID, "gpib_stats",               all_pid(M2_CODE_GUI),                 BLOB_CALLBACK(gpib_stats_csf),     0x00);
+	control_server_connect(M2_TS_ID, "gpib_forget",              all_pid(M2_CODE_GUI) | M2_CODE_SETUP, BLOB_CALLBACK(gpib_forget_csf),    0x00);
 	control_server_connect(M2_TS_ID, "catch_sweep_zerostop",     all_pid(M2_CODE_GUI),                 BLOB_CALLBACK(catch_sweep_csf),    0x10, tv);
 	control_server_connect(M2_TS_ID, "catch_sweep_min",          all_pid(M2_CODE_GUI),                 BLOB_CALLBACK(catch_sweep_csf),    0x10, tv);
 	control_server_connect(M2_TS_ID, "catch_sweep_max",          all_pid(M2_CODE_GUI),                 BLOB_CALLBACK(catch_sweep_csf),    0x10, tv);
@@ -54,6 +56,7 @@ void thread_register_panel (ThreadVars *tv, Panel *panel)
 	
 	control_server_connect(M2_TS_ID, "clear_buffer", M2_CODE_GUI << panel->pid, BLOB_CALLBACK(clear_csf),      0x30, tv, &panel->buffer, &panel->plot);
 	control_server_connect(M2_TS_ID, "gpib_pause",   M2_CODE_GUI << panel->pid, BLOB_CALLBACK(gpib_pause_csf), 0x20, tv, &panel->logger);
+	control_server_connect(M2_TS_ID, "scan_stats",   M2_CODE_GUI << panel->pid, BLOB_CALLBACK(scan_stats_csf), 0x10, &panel->scope);
 
 	snazzy_connect(panel->logger.button,       "clicked",              SNAZZY_VOID_VOID, BLOB_CALLBACK(record_cb),     0x10, tv);
 	snazzy_connect(panel->scope.button,        "clicked",              SNAZZY_VOID_VOID, BLOB_CALLBACK(scan_cb),       0x10, tv);
@@ -97,6 +100,7 @@ void run_gui_thread (ThreadVars *tv, Channel *channel_array, Panel *panel_array)
 	{
 		tv->data_gui[vci]  = tv->data_shared[vci]  = tv->data_daq[vci]  = 0;
 		tv->known_gui[vci] = tv->known_shared[vci] = tv->known_daq[vci] = 0;
+		tv->seq_recorded[vci] = 0;
 	}
 
 	// timing
@@ -104,6 +108,7 @@ void run_gui_thread (ThreadVars *tv, Channel *channel_array, Panel *panel_array)
 	Timer *limit_timer  _timerfree_ = timer_new();
 	Timer *reader_timer _timerfree_ = timer_new();
 	Timer *buffer_timer _timerfree_ = timer_new();
+	Timer *gpib_timer   _timerfree_ = timer_new();
 
 	double limit_target  = 1.0 / M2_DEFAULT_GUI_RATE;
 	double boost_target  = 1.0 / M2_BOOST_GUI_RATE;
@@ -159,12 +164,13 @@ void run_gui_thread (ThreadVars *tv, Channel *channel_array, Panel *panel_array)
 
 		if (overtime_then_reset(buffer_timer, buffer_target))
 		{
-			mt_mutex_lock(&buffer->mutex);
+			// no locking: the sets and points are published by the DAQ thread (see varset.h), and only this thread replaces buffer->svs
 			long total  = total_pts(buffer->svs);
-			bool primed = (buffer->svs->last_vs->N_pt == 0);
-			int sets    = buffer->svs->N_set - (primed ? 1 : 0);
-			int percent = buffer->percent;
-			mt_mutex_unlock(&buffer->mutex);
+			int sets    = svs_published(buffer->svs);
+			VSP last_vs = svs_vset(buffer->svs, sets - 1);
+			bool primed = (last_vs != NULL && vs_published(last_vs) == 0);
+			int percent = __atomic_load_n(&buffer->percent, __ATOMIC_RELAXED);
+			if (primed) sets--;
 
 			plot_buffer(plot, total, sets);
 			plot_scope(plot, percent);
@@ -172,11 +178,11 @@ void run_gui_thread (ThreadVars *tv, Channel *channel_array, Panel *panel_array)
 			set_buffer_buttons(buffer, total == 0, !primed);
 		}
 
+		if (chanset->N_gpib > 0 && overtime_then_reset(gpib_timer, M2_GPIB_STATS_WINDOW)) gpib_stats_update(&panel->logger);
+
 		if (plot_active(plot))
 		{
-			mt_mutex_lock(&buffer->mutex);
 			draw_request = min_long(total_pts(buffer->svs) - plot->draw_total, M2_MAX_GRADUAL_PTS);
-			mt_mutex_unlock(&buffer->mutex);
 
 			if (draw_request > 0) plot_tick(plot, draw_request);
 		}
@@ -27,6 +27,9 @@ static char * catch_scan_csf (gchar **argv);
 static char * clear_csf (gchar **argv, ThreadVars *tv, Buffer *buffer, Plot *plot);
 static char * gpib_send_recv_csf (gchar **argv, ThreadVars *tv);
 static char * gpib_pause_csf (gchar **argv, ThreadVars *tv, Logger *logger);
+static char * gpib_stats_csf (gchar **argv);
+static char * gpib_forget_csf (gchar **argv);
+static char * scan_stats_csf (gchar **argv, Scope *scope);
 
 char * read_channel_csf (gchar **argv, ChanSet *chanset, double *data, bool *known)
 {
@@ -129,7 +132,16 @@ char * gpib_send_recv_csf (gchar **argv, ThreadVars *tv)
 	    scan_arg_string(argv[4], "msg",          &msg) &&
 	    scan_arg_bool  (argv[5], "expect_reply", &expect_reply))
 	{
-		if (tv->pid == -1)
+		int priority = 0;
+		double timeout = M2_GPIB_REQUEST_TIMEOUT;
+		for (int k = 6; argv[k] != NULL; k++)  // optional
+			if (!scan_arg_int(argv[k], "priority", &priority) && !scan_arg_double(argv[k], "timeout", &timeout))
+			{
+				free(msg);
+				return cat1("argument_error");
+			}
+
+		if (tv->pid == -1 || !gpib_board_connected(id))  // no worker thread to hand off to (an unconnected board just fails quickly)
 		{
 			if (eos) gpib_device_set_eos(id, pad, eos);
 
@@ -139,19 +151,76 @@ char * gpib_send_recv_csf (gchar **argv, ThreadVars *tv)
 		else
 		{
 			mt_mutex_lock(&tv->gpib_mutex);
-			tv->gpib_id = id;
-			tv->gpib_pad = pad;
-			tv->gpib_eos = eos;
-			tv->gpib_msg = msg;
-			tv->gpib_expect_reply = expect_reply;
+			bool full = (tv->N_gpib_request == M2_GPIB_MAX_REQUEST);
+			if (!full)
+			{
+				struct GpibRequest *req = &tv->gpib_request[tv->N_gpib_request++];
+				req->id = id;
+				req->pad = pad;
+				req->eos = eos;
+				req->msg = msg;
+				req->expect_reply = expect_reply;
+				req->priority = priority;
+				req->t_expire = timer_elapsed(tv->gpib_clock) + timeout;
+			}
 			mt_mutex_unlock(&tv->gpib_mutex);
 
-			return NULL;  // reply later, in GPIB thread
+			if (full)
+			{
+				free(msg);
+				return cat1("busy");
+			}
+
+			gpib_multi_interrupt(id);  // don't wait for the rest of the polling round
+
+			if (expect_reply) return NULL;  // reply later, in that board's GPIB thread
+			else return cat1(get_cmd(M2_TS_ID));  // queued, so the terminal can go on to the next one
 		}
 	}
 	else return cat1("argument_error");
 }
 
+char * gpib_stats_csf (gchar **argv)
+{
+	f_start(F_CONTROL);
+
+	int id, s = -1;
+	if (scan_arg_int(argv[1], "id", &id) && (argv[2] == NULL || scan_arg_int(argv[2], "slot", &s)))
+	{
+		if (s == -1)  // whole board
+		{
+			GpibBoardStats stats;
+			if (gpib_board_connected(id) && gpib_board_stats(id, &stats))
+				return supercat("%s;N_slot|%d;N_suspended|%d;utilization|%f;load|%f;N_query|%ld;N_timeout|%ld;N_write|%ld;N_down|%d",
+				                argv[0], stats.N_slot, stats.N_suspended, stats.utilization, stats.load, stats.N_query, stats.N_timeout, stats.N_write, stats.N_down);
+		}
+		else
+		{
+			GpibSlotStats stats;
+			if (gpib_board_connected(id) && gpib_slot_stats(id, s, &stats))
+				return supercat("%s;pad|%d;send_time|%f;reply_time|%f;rate|%f;rate_target|%f;N_query|%ld;N_timeout|%ld;N_late|%ld;N_write|%ld;N_write_merged|%ld;responding|%d;timeout|%f;refs|%d",
+				                argv[0], stats.pad, stats.send_time, stats.reply_time, stats.rate, stats.rate_target,
+				                stats.N_query, stats.N_timeout, stats.N_late, stats.N_write, stats.N_write_merged, stats.responding ? 1 : 0, stats.timeout, stats.refs);
+		}
+	}
+
+	return cat1("argument_error");
+}
+
+char * gpib_forget_csf (gchar **argv)
+{
+	f_start(F_CONTROL);
+
+	int id, pad = -1;
+	if (scan_arg_int(argv[1], "id", &id) && (argv[2] == NULL || scan_arg_int(argv[2], "pad", &pad)) && id >= 0 && id < M2_GPIB_MAX_BRD && pad >= -1 && pad < M2_GPIB_MAX_PAD)
+	{
+		gpib_device_forget(id, pad);  // identified again when next needed
+		return cat1(argv[0]);
+	}
+
+	return cat1("argument_error");
+}
+
 char * gpib_pause_csf (gchar **argv, ThreadVars *tv, Logger *logger)
 {
 	f_start(F_CONTROL);
@@ -212,3 +281,24 @@ char * clear_csf (gchar **argv, ThreadVars *tv, Buffer *buffer, Plot *plot)
 	}
 	else return cat1("argument_error");
 }
+
+char * scan_stats_csf (gchar **argv, Scope *scope)
+{
+	f_start(F_CONTROL);
+
+	int id;
+	if (scan_arg_int(argv[1], "id", &id) && id >= 0 && id < M2_NUM_DAQ)
+	{
+		mt_mutex_lock(&scope->mutex);
+		bool scanning = scope->scanning;
+		ScanStats stats = scope->scan[id].stats;
+		mt_mutex_unlock(&scope->mutex);
+
+		if (scanning) return cat1("scan_in_progress");
+
+		return supercat("%s;N_read|%ld;N_poll|%ld;N_retry|%ld;N_overrun|%ld;N_missing|%ld;peak_fill|%f;bytes_per_read|%f;read_latency|%f;read_latency_max|%f;throughput|%f;process_time|%f",
+		                argv[0], stats.N_read, stats.N_poll, stats.N_retry, stats.N_overrun, stats.N_missing, stats.peak_fill,
+		                stats.bytes_per_read, stats.read_latency, stats.read_latency_max, stats.throughput, stats.process_time);
+	}
+	else return cat1("argument_error");
+}
@@ -54,6 +54,7 @@ void buffer_init (Buffer *buffer, GtkWidget *parent)
 
 	mt_mutex_init(&buffer->mutex);
 	mt_mutex_init(&buffer->confirming);
+	mt_mutex_init(&buffer->saving);
 
 	buffer->svs = NULL;
 	buffer->timer = timer_new();
@@ -62,6 +63,7 @@ void buffer_init (Buffer *buffer, GtkWidget *parent)
 
 	buffer->filename = NULL;
 	buffer->locked = 0;
+	buffer->columnar = 0;
 
 	buffer->displayed_empty = 0;
 	buffer->displayed_filling = 1;
@@ -104,6 +106,7 @@ void buffer_final (Buffer *buffer)
 
 	mt_mutex_clear(&buffer->mutex);
 	mt_mutex_clear(&buffer->confirming);
+	mt_mutex_clear(&buffer->saving);
 	free_svset(buffer->svs);
 	timer_destroy(buffer->timer);
 }
@@ -114,6 +117,9 @@ void buffer_register (Buffer *buffer, int pid, ChanSet *chanset)
 
 	mcf_register(NULL, "# Buffers", MCF_W);
 
+	int columnar_var = mcf_register(&buffer->columnar, atg(supercat("panel%d_buffer_columnar_storage", pid)), MCF_BOOL | MCF_W | MCF_DEFAULT, 0);
+	mcf_connect(columnar_var, "setup, panel", BLOB_CALLBACK(set_bool_mcf), 0x00);
+
 	snazzy_connect(buffer->tzero_button, "clicked",                          SNAZZY_VOID_VOID, BLOB_CALLBACK(tzero_cb),         0x10, buffer);
 	snazzy_connect(buffer->add_button,   "clicked",                          SNAZZY_VOID_VOID, BLOB_CALLBACK(add_set_cb),       0x20, buffer, chanset);
 	snazzy_connect(buffer->file_entry,   "key-press-event, focus-out-event", SNAZZY_BOOL_PTR,  BLOB_CALLBACK(filename_cb),      0x10, buffer);
@@ -162,9 +168,9 @@ bool clear_buffer (Buffer *buffer, ChanSet *chanset, bool confirm, bool tzero)
 	{
 		mt_mutex_lock(&buffer->confirming);
 
-		mt_mutex_lock(&buffer->mutex);
+		mt_mutex_lock(&buffer->saving);
 		confirm = unsaved_data(buffer->svs);
-		mt_mutex_unlock(&buffer->mutex);
+		mt_mutex_unlock(&buffer->saving);
 
 		if (confirm) proceed = run_yes_no_dialog(buffer->main_window, "There are unsaved points in the buffer.\nClear buffer anyway?");
 
@@ -178,16 +184,21 @@ bool clear_buffer (Buffer *buffer, ChanSet *chanset, bool confirm, bool tzero)
 
 		if (svs != NULL && vs != NULL)
 		{
+			set_columnar(vs, buffer->columnar);
 			append_vset(svs, vs);
 
 			mt_mutex_lock(&buffer->mutex);
-			free_svset(buffer->svs);
+			SVSP old_svs = buffer->svs;
 			buffer->svs = svs;
 			buffer->locked = 0;
 			if (tzero) buffer->do_time_reset = 1;
-			buffer->percent = 0;
+			__atomic_store_n(&buffer->percent, 0, __ATOMIC_RELAXED);
 			mt_mutex_unlock(&buffer->mutex);
 
+			mt_mutex_lock(&buffer->saving);  // a save from the DAQ thread may still be reading the old sets
+			free_svset(old_svs);
+			mt_mutex_unlock(&buffer->saving);
+
 			status_add(1, supercat("Cleared buffer (Time reset: %s)\n", tzero ? "Y" : "N"));
 		}
 		else
@@ -210,6 +221,7 @@ bool add_set (Buffer *buffer, ChanSet *chanset)  // needs outer locks
 		VSP vs = prepare_vset(chanset);
 		if (vs != NULL)
 		{
+			set_columnar(vs, buffer->columnar);
 			append_vset(buffer->svs, vs);
 			return 1;
 		}
@@ -222,18 +234,24 @@ long save_buffer (Buffer *buffer, const char *filename, bool always_append, bool
 {
 	f_start(F_RUN);
 
+	// Only published points are written (see varset.h), so the DAQ thread can keep appending
+	// meanwhile. Holding Buffer.saving keeps clear_buffer() from freeing the sets underneath us.
+
+	mt_mutex_lock(&buffer->saving);
+
 	mt_mutex_lock(&buffer->mutex);
-	long N_pt = write_svset_custom(buffer->svs, NULL, 0, filename, *buffer->save_header, always_append, overwrite);
+	SVSP svs = buffer->svs;  // save_csf() may run in the DAQ thread, which does not own svs
 	mt_mutex_unlock(&buffer->mutex);
 
+	long N_pt = write_svset_custom(svs, NULL, 0, filename, *buffer->save_header, always_append, overwrite);
+	mt_mutex_unlock(&buffer->saving);
+
 	return N_pt;
 }
 
 void set_scan_progress (Buffer *buffer, double frac)
 {
-	mt_mutex_lock(&buffer->mutex);
-	buffer->percent = (frac < 0) ? -1 : min_int((int) (frac * 100), 100);
-	mt_mutex_unlock(&buffer->mutex);
+	__atomic_store_n(&buffer->percent, (frac < 0) ? -1 : min_int((int) (frac * 100), 100), __ATOMIC_RELAXED);
 }
 
 void set_buffer_buttons (Buffer *buffer, bool empty, bool filling)
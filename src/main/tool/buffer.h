@@ -29,6 +29,7 @@ typedef struct
 	// private:
 
 		MtMutex confirming;
+		MtMutex saving;                           // held while exporting and while freeing old sets
 
 		bool *save_header, *save_mcf, *save_scr;  // threads: shared (read only), inherited from Bufmenu, TODO: use save_mcf, save_scr
 
@@ -39,8 +40,9 @@ typedef struct
 
 		bool displayed_empty, displayed_filling;  // threads: GUI only
 
-		int percent;                              // threads: shared (used for scan progress)
+		int percent;                              // threads: shared (used for scan progress, accessed atomically)
 		char *filename;                           // threads: GUI only
+		bool columnar;                            // threads: shared (read only), layout of new sets, see set_columnar()
 
 	// public:
 
@@ -49,7 +51,9 @@ typedef struct
 		bool *link_tzero;  // threads: GUI only, inherited from Bufmenu
 
 	  	// The following vars are shared between threads and protected by Buffer.mutex,
-		// except for 'locked' which is only accessed by the GUI thread.
+		// except for 'locked' which is only accessed by the GUI thread. Buffer.mutex serializes
+		// the writers of svs; the GUI thread may read svs without it, since it is the only thread
+		// that replaces svs, and the sets and points themselves are published (see varset.h).
 
 		SVSP svs;
 		Timer *timer;
@@ -25,6 +25,7 @@
 #include <lib/util/fs.h>
 #include <lib/util/str.h>
 #include <lib/util/num.h>
+#include <lib/hardware/gpib.h>
 
 #include "logger_callback.c"
 
@@ -84,8 +85,9 @@ void logger_init (Logger *logger, GtkWidget **apt)
 	logger->button = pack_start(gtk_button_new(), 0, control_vbox);
 	logger->image  = pack_start(gtk_image_new(),  0, control_vbox);
 
-	logger->gpib_button = pack_end(size_widget(gtk_check_button_new_with_label("Pause GPIB"), -1, 22), 0,
-	                      pack_end(gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 0), 0, lower_vbox));
+	GtkWidget *gpib_hbox = pack_end(gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 0), 0, lower_vbox);
+	logger->gpib_button = pack_end(size_widget(gtk_check_button_new_with_label("Pause GPIB"), -1, 22), 0, gpib_hbox);
+	logger->gpib_label  = pack_start(new_label("", 0, 0.0), 1, gpib_hbox);
 
 	mt_mutex_init(&logger->mutex);
 	logger->block_cbuf_length_cb = 0;
@@ -118,6 +120,9 @@ void logger_update (Logger *logger, ChanSet *chanset)
 	set_text_view_text(logger->reader_types,  chanset->N_total_chan > 0 ? atg(join_lines(type_str,  "\n", chanset->N_total_chan)) : " ");
 
 	set_visibility(logger->gpib_button, chanset->N_gpib > 0);
+	set_visibility(logger->gpib_label,  chanset->N_gpib > 0);
+	gtk_label_set_text(GTK_LABEL(logger->gpib_label), "");
+	gtk_widget_set_tooltip_text(logger->gpib_label, NULL);
 	gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(logger->gpib_button), 0);  // not paused
 }
 
@@ -207,6 +212,40 @@ void reader_update (Logger *logger, ChanSet *chanset, bool *known, double *data)
 	}
 }
 
+void gpib_stats_update (Logger *logger)
+{
+	f_start(F_NONE);
+
+	char *label_str   _strfree_ = cat1("");
+	char *tooltip_str _strfree_ = cat1("");
+
+	for (int id = 0; id < M2_NUM_GPIB; id++)
+	{
+		GpibBoardStats board;
+		if (!gpib_board_connected(id) || !gpib_board_stats(id, &board) || board.N_slot == 0) continue;
+
+		char *down_str = atg(board.N_down > 0 ? supercat(" (%d down)", board.N_down) : cat1(""));
+		replace(label_str, supercat("%s%sGPIB%d %1.0f%%%s", label_str, str_length(label_str) > 0 ? "  " : "", id, 1e2 * board.utilization, down_str));
+		char *suspended_str = atg(board.N_suspended > 0 ? supercat(", %d unused slots suspended", board.N_suspended) : cat1(""));
+		replace(tooltip_str, supercat("%s%sGPIB%d: %1.0f%% busy, %1.0f%% requested, %ld queries, %ld timeouts, %ld writes%s",
+		                              tooltip_str, str_length(tooltip_str) > 0 ? "\n\n" : "", id, 1e2 * board.utilization, 1e2 * board.load, board.N_query, board.N_timeout, board.N_write, suspended_str));
+
+		for (int s = 0; s < board.N_slot + board.N_suspended; s++)
+		{
+			GpibSlotStats slot;
+			if (!gpib_slot_stats(id, s, &slot) || slot.refs == 0) continue;
+
+			char *time_str = atg(slot.send_time >= 0 ? supercat(", %1.1f + %1.1f ms", 1e3 * slot.send_time, 1e3 * slot.reply_time) : cat1(""));
+			char *fail_str = atg(!slot.responding    ? cat1(", not responding") :
+			                     slot.N_timeout > 0  ? supercat(", %ld timeouts", slot.N_timeout) : cat1(""));
+			replace(tooltip_str, supercat("%s\n   PAD %d %s: %1.1f of %1.1f Hz%s%s", tooltip_str, slot.pad, atg(str_strip_end(slot.cmd, "\n\r")), slot.rate, slot.rate_target, time_str, fail_str));
+		}
+	}
+
+	gtk_label_set_text(GTK_LABEL(logger->gpib_label), label_str);
+	gtk_widget_set_tooltip_text(logger->gpib_label, str_length(tooltip_str) > 0 ? tooltip_str : NULL);
+}
+
 void logger_final (Logger *logger)
 {
 	f_start(F_INIT);
@@ -59,6 +59,7 @@ typedef struct
 
 		MtMutex mutex;
 		GtkWidget *button, *image, *gpib_button;
+		GtkWidget *gpib_label;  // bus utilization, per-slot details in the tooltip
 
 	  	// The following vars are shared between threads and protected by Logger.mutex.
 
@@ -74,6 +75,7 @@ void logger_update   (Logger *logger, ChanSet *chanset);
 void logger_final    (Logger *logger);
 
 void reader_update       (Logger *logger, ChanSet *chanset, bool *known, double *data);
+void gpib_stats_update   (Logger *logger);
 void set_logger_runlevel (Logger *logger, int rl);
 void set_logger_scanning (Logger *logger, bool scanning);
 
@@ -28,6 +28,7 @@
 
 static void verify_timescale (Scope *scope);  // lock before calling
 static void update_readout   (Scope *scope);  // locking not required
+static void report_stats     (int id, ScanStats *stats);
 
 #include "scope_callback.c"
 
@@ -83,6 +84,7 @@ void set_scope_runlevel (Scope *scope, int rl)
 	gtk_widget_set_sensitive(scope->time_entry->widget, rl != SCOPE_RL_SCAN);
 
 	gtk_button_set_label(GTK_BUTTON(scope->button), rl == SCOPE_RL_SCAN ? "CANCEL" : "SCAN");
+	if (rl == SCOPE_RL_READY) update_readout(scope);  // show stats from the last scan
 	gtk_image_set_from_file(GTK_IMAGE(scope->image), atg(sharepath(rl == SCOPE_RL_SCAN  ? "pixmaps/rl_scan.png"  :
 	                                                               rl == SCOPE_RL_READY ? "pixmaps/rl_ready.png" :
 	                                                               rl == SCOPE_RL_HOLD  ? "pixmaps/rl_hold.png"  :
@@ -178,14 +180,18 @@ void update_readout (Scope *scope)  // locking not required
 
 		if (scan->N_chan > 0)
 		{
-			left[id] = atg(id != M2_VDAQ_ID ? supercat("DAQ%d:\n", id) : cat1("VDAQ:\n"));
+			bool stats = (scan->status == 1 && scan->stats.N_read > 0);
+			left[id] = atg(id != M2_VDAQ_ID ? supercat("DAQ%d:\n%s", id, stats ? "\n" : "") : supercat("VDAQ:\n%s", stats ? "\n" : ""));
 
 			if (scan->status == 1)
 			{
 				char *points_str = atg(scan->N_pt < 1000    ? supercat("%d pt",              scan->N_pt)     :
 				                       scan->N_pt < 1000000 ? supercat("%1.2f kpt", (double) scan->N_pt/1e3) :
 				                                              supercat("%1.2f Mpt", (double) scan->N_pt/1e6));
-				right[id] = atg(supercat("%s (%d ch/pt)\n%1.6f kHz", points_str, scan->N_chan, scan->rate_kHz));
+				char *stats_str = atg(!stats                      ? cat1("") :
+				                      scan->stats.peak_fill >= 0 ? supercat("\nlast: %ld reads, %1.0f%% fill, %ld lost", scan->stats.N_read, 1e2 * scan->stats.peak_fill, scan->stats.N_missing) :
+				                                                   supercat("\nlast: %ld reads, %ld lost",              scan->stats.N_read,                             scan->stats.N_missing));
+				right[id] = atg(supercat("%s (%d ch/pt)\n%1.6f kHz%s", points_str, scan->N_chan, scan->rate_kHz, stats_str));
 			}
 			else right[id] = atg(cat1("Setup error"));
 		}
@@ -198,29 +204,43 @@ void update_readout (Scope *scope)  // locking not required
 
 bool scan_array_start (Scan *scan_array, Timer *timer)
 {
+	// Arm every board first, then release them back to back, so that the only skew left is the
+	// time between triggers. The measured start times are used by scan_array_process() to align.
+
 	double t_called = timer_elapsed(timer);
 
 	for (int id = 0; id < M2_NUM_DAQ; id++)
-		if (scan_array[id].status == 1)
+		if (scan_array[id].status == 1 && daq_SCAN_arm(id) != 1)
 		{
-			if (daq_SCAN_start(id) != 1)
-			{
-				f_print(F_ERROR, "Error: daq_SCAN_start() failed.\n");
-				return 0;
-			}
+			f_print(F_ERROR, "Error: daq_SCAN_arm() failed.\n");
+			return 0;
+		}
+
+	double t_armed = timer_elapsed(timer);
+
+	for (int id = 0; id < M2_NUM_DAQ; id++)
+		if (scan_array[id].status == 1 && daq_SCAN_trigger(id) != 1)
+		{
+			f_print(F_ERROR, "Error: daq_SCAN_trigger() failed.\n");
+			return 0;
 		}
 
-	f_print(F_BENCH, "Info: Called at %1.3f msec, returned %1.3f msec later.\n", 1e3 * t_called, 1e3 * (timer_elapsed(timer) - t_called));
+	int ref_id = -1;
+	for (int id = 0; id < M2_NUM_DAQ; id++)
+		if (scan_array[id].status == 1 && (ref_id == -1 || daq_SCAN_t0(id) < daq_SCAN_t0(ref_id))) ref_id = id;
+
+	for (int id = 0; id < M2_NUM_DAQ; id++)
+		if (scan_array[id].status == 1) scan_array[id].t_offset = daq_SCAN_align(id, daq_SCAN_t0(ref_id));
+
+	f_print(F_BENCH, "Info: Called at %1.3f msec, armed %1.3f msec later, returned %1.3f msec later.\n", 1e3 * t_called, 1e3 * (t_armed - t_called), 1e3 * (timer_elapsed(timer) - t_called));
 	return 1;
 }
 
-void scan_array_read (Scan *scan_array, int *counter, int *read_mult, long *s_read_total)
+void scan_array_read (Scan *scan_array, int *counter, long *s_read_total)
 {
 	for (int id = 0; id < M2_NUM_DAQ; id++)
 	{
-		if (scan_array[id].status == 1 && counter[id] % read_mult[id] == 0 && counter[id] != 0)  // skip first time
-			s_read_total[id] += daq_SCAN_read(id);
-
+		if (scan_array[id].status == 1) s_read_total[id] += daq_SCAN_poll(id);  // reads only when the device buffer is due
 		counter[id]++;
 	}
 }
@@ -232,6 +252,9 @@ void scan_array_stop (Scan *scan_array, long *s_read_total)
 		{
 			s_read_total[id] += daq_SCAN_stop(id);  // clean up extra data and stop device (if necessary)
 			f_print(F_RUN, "Info: daq_SCAN_read(%d) saved %ld samples.\n", id, s_read_total[id]);
+
+			daq_SCAN_stats(id, &scan_array[id].stats);
+			scan_array[id].stats.process_time = 0;  // until scan_array_process()
 		}
 }
 
@@ -239,6 +262,7 @@ void scan_array_process (Scan *scan_array, Buffer *buffer, ChanSet *chanset)
 {
 	f_start(F_RUN);
 
+	Timer *timer _timerfree_ = timer_new();
 	double full_data [M2_MAX_CHAN];
 	double prefactor [M2_MAX_CHAN];
 
@@ -252,28 +276,51 @@ void scan_array_process (Scan *scan_array, Buffer *buffer, ChanSet *chanset)
 	if (buffer->svs->last_vs->N_pt > 0) add_set(buffer, chanset);
 	VSP vs = buffer->svs->last_vs;
 
+	// One row per point of the reference board (the one with the most points), timed from the
+	// start of the earliest board. Other boards are resampled onto those times.
+	int ref_id = -1;
 	for (int id = 0; id < M2_NUM_DAQ; id++)
+		if (scan_array[id].status == 1 && (ref_id == -1 || scan_array[id].N_pt > scan_array[ref_id].N_pt)) ref_id = id;
+
+	if (ref_id != -1)
 	{
-		Scan *scan = &scan_array[id];
-		if (scan->status == 1)
+		Scan *scan = &scan_array[ref_id];
+		for (long j = 0; j < scan->N_pt; j++)
 		{
-			for (long j = 0; j < scan->N_pt; j++)
-			{
-				compute_set_time((double) j / (scan->rate_kHz * 1e3));
-				compute_set_point(j);
+			compute_set_time(scan->t_offset + (double) j / (scan->rate_kHz * 1e3));
+			compute_set_point(j);
 
-				for (int vci = 0; vci < chanset->N_total_chan; vci++)
-					compute_function_read(&chanset->channel_by_vci[vci]->cf, COMPUTE_MODE_SCAN, &full_data[vci]);
+			for (int vci = 0; vci < chanset->N_total_chan; vci++)
+				compute_function_read(&chanset->channel_by_vci[vci]->cf, COMPUTE_MODE_SCAN, &full_data[vci]);
 
-				append_point(vs, full_data);
-			}
+			append_point(vs, full_data);
+		}
+	}
 
+	for (int id = 0; id < M2_NUM_DAQ; id++)
+		if (scan_array[id].status == 1)
+		{
+			scan_array[id].stats.process_time = timer_elapsed(timer);
 			daq_SCAN_prepare(id, &scan_array[id]);  // re-prepare scan (timescale should not have changed because callbacks are blocked during scanning)
 		}
-	}
 	
 	if (buffer->svs->last_vs->N_pt > 0) add_set(buffer, chanset);  // add another set for future logging if this one got any data
 	mt_mutex_unlock(&buffer->mutex);
 
 	compute_restore_context();  // put logger settings back
+
+	for (int id = 0; id < M2_NUM_DAQ; id++)
+		if (scan_array[id].status == 1) report_stats(id, &scan_array[id].stats);
+}
+
+void report_stats (int id, ScanStats *stats)
+{
+	char *fill_str = atg(stats->peak_fill >= 0 ? supercat("peak fill %1.0f%%", 1e2 * stats->peak_fill) : cat1("fill unknown"));
+	status_add(1, supercat("DAQ%d scan: %1.1f kS/s, %ld reads of %1.1f kB (%1.2f/%1.2f ms mean/max), %s, processed in %1.0f ms.\n",
+	                       id, stats->throughput / 1e3, stats->N_read, stats->bytes_per_read / 1e3, 1e3 * stats->read_latency, 1e3 * stats->read_latency_max, fill_str, 1e3 * stats->process_time));
+
+	if (stats->N_overrun > 0) status_add(1, supercat("Warning: DAQ%d scan overran the device buffer %ld time(s).\n", id, stats->N_overrun));
+	if (stats->N_missing > 0) status_add(1, supercat("Warning: DAQ%d scan is missing %ld samples (%ld extra reads).\n", id, stats->N_missing, stats->N_retry));
+
+	f_print(F_BENCH, "DAQ%d: %ld reads in %ld polls, %ld retries, %ld overruns, overrun margin %1.1f%%\n", id, stats->N_read, stats->N_poll, stats->N_retry, stats->N_overrun, stats->peak_fill >= 0 ? 1e2 * (1 - stats->peak_fill) : 0.0);
 }
@@ -62,7 +62,7 @@ void scope_update   (Scope *scope, ChanSet *chanset);
 void scope_final    (Scope *scope);
 
 bool scan_array_start   (Scan *scan_array, Timer *timer);                                      // call from DAQ thread
-void scan_array_read    (Scan *scan_array, int *counter, int *read_mult, long *s_read_total);  // call from DAQ thread
+void scan_array_read    (Scan *scan_array, int *counter, long *s_read_total);                  // call from DAQ thread
 void scan_array_stop    (Scan *scan_array, long *s_read_total);                                // call from DAQ thread
 void scan_array_process (Scan *scan_array, Buffer *buffer, ChanSet *chanset);                  // call from DAQ thread
 